@@ -7,600 +7,5555 @@
 #include <string.h>
 
 #if defined(__unix)
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <pthread.h>
     #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/uio.h>
     #include <unistd.h>
+    // io_uring needs the syscall numbers and a 5.6 kernel header, which brought
+    // IORING_OP_WRITE along with IORING_FEAT_RW_CUR_POS. Builds without them
+    // use the writer thread.
+    #if defined(__linux__) && defined(__has_include)
+        #if __has_include(<linux/io_uring.h>)
+            #include <linux/io_uring.h>
+            #include <sys/syscall.h>
+            #if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(IORING_FEAT_RW_CUR_POS)
+                #define SAMLIB_URING
+            #endif
+        #endif
+    #endif
 #else
     #include <windows.h>
 #endif
 
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define SAMLIB_X86
+    #include <immintrin.h>
+    #if defined(__GNUC__)
+        #define SIMD_TARGET(isa) __attribute__((target(isa)))
+    #else
+        #define SIMD_TARGET(isa)
+    #endif
+#endif
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                   BITS                                    */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Index of the highest set bit, `val` must not be 0.
+local u32 msb_index(u64 val) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanReverse64(&idx, val);
+    return idx;
+#else
+    return 63 - __builtin_clzll(val);
+#endif
+}
+
+// Index of the lowest set bit, `val` must not be 0.
+local u32 lsb_index(u64 val) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, val);
+    return idx;
+#else
+    return __builtin_ctzll(val);
+#endif
+}
+
+local u32 popcount_u64(u64 val) {
+#if defined(_MSC_VER)
+    return (u32)__popcnt64(val);
+#else
+    return (u32)__builtin_popcountll(val);
+#endif
+}
+
+// Full 64x64 -> 128-bit product, returns the low half.
+local u64 umul128(u64 a, u64 b, u64* high) {
+#if defined(_MSC_VER)
+    return _umul128(a, b, high);
+#else
+    unsigned __int128 product = (unsigned __int128)a * b;
+    *high = (u64)(product >> 64);
+    return (u64)product;
+#endif
+}
+
+// Unaligned little endian load.
+local u64 load_u64(const u8* p) {
+    u64 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// `(high:low) >> shift` for 0 < shift < 64.
+local u64 shift_right128(u64 low, u64 high, u32 shift) {
+    return (high << (64 - shift)) | (low >> shift);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                  ATOMICS                                  */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#if defined(_MSC_VER)
+local u64 atomic_load_u64(u64* ptr) {
+    return *(volatile u64*)ptr;
+}
+
+local b8 atomic_cas_u64(u64* ptr, u64* expected, u64 desired) {
+    u64 prev = (u64)_InterlockedCompareExchange64((volatile long long*)ptr, (long long)desired, (long long)*expected);
+    if (prev == *expected) return true;
+    *expected = prev;
+    return false;
+}
+#else
+local u64 atomic_load_u64(u64* ptr) {
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+local b8 atomic_cas_u64(u64* ptr, u64* expected, u64 desired) {
+    return __atomic_compare_exchange_n(ptr, expected, desired, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+#endif
+
+local void spin_lock(u32* lock) {
+#if defined(_MSC_VER)
+    while (_InterlockedExchange((volatile long*)lock, 1) != 0) {
+        while (*(volatile u32*)lock != 0) _mm_pause();
+    }
+#else
+    while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE) != 0) {
+        while (__atomic_load_n(lock, __ATOMIC_RELAXED) != 0) {
+    #if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+    #endif
+        }
+    }
+#endif
+}
+
+local void spin_unlock(u32* lock) {
+#if defined(_MSC_VER)
+    _InterlockedExchange((volatile long*)lock, 0);
+#else
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+#endif
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                  HASHING                                  */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// wyhash (Wang Yi, final version 4): 48 bytes per round over three
+// independent lanes, one 64x64 -> 128-bit multiply per 16 bytes. Output is
+// identical on every CPU, so hashes can be stored.
+
+local const u64 hash_secret[4] = {
+    0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull,
+};
+
+local u64 hash_mix(u64 a, u64 b) {
+    u64 high;
+    u64 low = umul128(a, b, &high);
+    return low ^ high;
+}
+
+local u64 load_u32(const u8* p) {
+    u32 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+local u64 hash_seed(u64 seed) {
+    return seed ^ hash_mix(seed ^ hash_secret[0], hash_secret[1]);
+}
+
+local u64 hash_finish(u64 a, u64 b, u64 seed, u64 length) {
+    a ^= hash_secret[1];
+    b ^= seed;
+    a  = umul128(a, b, &b);
+    return hash_mix(a ^ hash_secret[0] ^ length, b ^ hash_secret[1]);
+}
+
+// Inputs of at most 16 bytes, read as two possibly overlapping halves.
+local u64 hash_short(const u8* p, u64 length, u64 seed) {
+    u64 a = 0;
+    u64 b = 0;
+    if (length >= 4) {
+        u64 mid = (length >> 3) << 2;
+        a = (load_u32(p) << 32) | load_u32(p + mid);
+        b = (load_u32(p + length - 4) << 32) | load_u32(p + length - 4 - mid);
+    } else if (length > 0) {
+        a = ((u64)p[0] << 16) | ((u64)p[length >> 1] << 8) | p[length - 1];
+    }
+    return hash_finish(a, b, seed, length);
+}
+
+local void hash_block(u64 lanes[3], const u8* p) {
+    lanes[0] = hash_mix(load_u64(p) ^ hash_secret[1], load_u64(p + 8) ^ lanes[0]);
+    lanes[1] = hash_mix(load_u64(p + 16) ^ hash_secret[2], load_u64(p + 24) ^ lanes[1]);
+    lanes[2] = hash_mix(load_u64(p + 32) ^ hash_secret[3], load_u64(p + 40) ^ lanes[2]);
+}
+
+// The last 1..48 bytes at `p`, the 16 bytes before them must be readable when
+// fewer than 16 remain.
+local u64 hash_tail(const u8* p, u64 remaining, u64 seed, u64 length) {
+    while (remaining > 16) {
+        seed       = hash_mix(load_u64(p) ^ hash_secret[1], load_u64(p + 8) ^ seed);
+        p         += 16;
+        remaining -= 16;
+    }
+    return hash_finish(load_u64(p + remaining - 16), load_u64(p + remaining - 8), seed, length);
+}
+
+u64 mem_hash(const void* data, u64 length, u64 seed) {
+    const u8* p = data;
+    seed = hash_seed(seed);
+    if (length <= 16) return hash_short(p, length, seed);
+
+    u64 remaining = length;
+    if (remaining > 48) {
+        u64 lanes[3] = { seed, seed, seed };
+        do {
+            hash_block(lanes, p);
+            p         += 48;
+            remaining -= 48;
+        } while (remaining > 48);
+        seed = lanes[0] ^ lanes[1] ^ lanes[2];
+    }
+    return hash_tail(p, remaining, seed, length);
+}
+
+u64 string_hash(const String str, u64 seed) {
+    return mem_hash(str.buffer, str.length, seed);
+}
+
+Hasher hasher_new(u64 seed) {
+    u64 mixed = hash_seed(seed);
+    return (Hasher) {
+        .lanes = { mixed, mixed, mixed },
+    };
+}
+
+// A block only runs once a byte is known to follow it, matching `mem_hash`
+// which always leaves 1..48 bytes for the tail.
+void hasher_update(Hasher* h, const void* data, u64 length) {
+    const u8* p    = data;
+    u8*       tail = h->buffer + 16;
+    h->length     += length;
+
+    if (h->buffered + length <= 48) {
+        if (length > 0) memcpy(tail + h->buffered, p, length);
+        h->buffered += (u32)length;
+        return;
+    }
+
+    const u8* last = NULL;
+    if (h->buffered > 0) {
+        u64 fill = 48 - h->buffered;
+        memcpy(tail + h->buffered, p, fill);
+        p      += fill;
+        length -= fill;
+        hash_block(h->lanes, tail);
+        last = tail;
+    }
+    while (length > 48) {
+        hash_block(h->lanes, p);
+        last    = p;
+        p      += 48;
+        length -= 48;
+    }
+    // Keep the end of the last block, the tail may read back into it.
+    memmove(h->buffer, last + 32, 16);
+    memcpy(tail, p, length);
+    h->buffered = (u32)length;
+}
+
+u64 hasher_finish(const Hasher* h) {
+    const u8* tail = h->buffer + 16;
+    if (h->length <= 16) return hash_short(tail, h->length, h->lanes[0]);
+
+    u64 seed = h->lanes[0];
+    if (h->length > 48) seed = h->lanes[0] ^ h->lanes[1] ^ h->lanes[2];
+    return hash_tail(tail, h->buffered, seed, h->length);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                               ARENA/MEMORY                                */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+local u64 os_page_size(void) {
+    persist u64 page_size = 0;
+    if (page_size == 0) {
+#if defined(__unix)
+        page_size = (u64)sysconf(_SC_PAGESIZE);
+#else
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        page_size = info.dwPageSize;
+#endif
+    }
+    return page_size;
+}
+
+#if defined(__unix)
+// Reads a small sysfs/procfs file into `buf` as a C string, "" when missing.
+local void os_read_text(const char* path, char* buf, u64 cap) {
+    buf[0] = 0;
+    s32 fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+    u64 length = 0;
+    for (;;) {
+        ssize_t got = read(fd, buf + length, cap - 1 - length);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        length += got;
+    }
+    buf[length] = 0;
+    close(fd);
+}
+#endif
+
+// Default size of explicit huge pages (hugetlbfs, large pages), 0 if none.
+local u64 os_hugetlb_page_size(void) {
+    persist u64 size = ALL64;
+    if (size == ALL64) {
+#if defined(__linux__)
+        char meminfo[8192];
+        os_read_text("/proc/meminfo", meminfo, sizeof(meminfo));
+        const char* line = strstr(meminfo, "Hugepagesize:");
+        size = line != NULL ? strtoull(line + sizeof("Hugepagesize:") - 1, NULL, 10) * KB(1) : 0;
+#elif defined(__unix)
+        size = 0;
+#else
+        size = GetLargePageMinimum();
+#endif
+    }
+    return size;
+}
+
+// Whether the kernel hands out transparent huge pages at all.
+local b8 os_thp_enabled(void) {
+    persist s32 enabled = -1;
+    if (enabled < 0) {
+#if defined(__linux__)
+        char mode[128];
+        os_read_text("/sys/kernel/mm/transparent_hugepage/enabled", mode, sizeof(mode));
+        enabled = mode[0] != 0 && strstr(mode, "[never]") == NULL;
+#else
+        enabled = 0;
+#endif
+    }
+    return enabled;
+}
+
+u64 arena_huge_page_size(void) {
+    persist u64 size = 0;
+    if (size == 0) {
+#if defined(__linux__)
+        // 2MB on x86-64, 512MB on arm64 with 64K base pages.
+        char text[32];
+        os_read_text("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", text, sizeof(text));
+        size = strtoull(text, NULL, 10);
+#endif
+        if (size == 0) size = os_hugetlb_page_size();
+        if (size == 0) size = MB(2);
+    }
+    return size;
+}
+
+local u64 align_up(u64 val, u64 alignment) {
+    return alignment * ((val + alignment - 1) / alignment);
+}
+
+#if defined(SAMLIB_ARENA_STATS)
+    #define ARENA_STAT(stmt) stmt
+#else
+    #define ARENA_STAT(stmt)
+#endif
+
+#define ARENA_SNAPSHOT_HEADER KB(4)
+
+// Chained blocks keep the previous block state at their start.
+#define ARENA_HEADER_SIZE (((sizeof(Arena) + 63) / 64) * 64)
+
+// Reserves `size` bytes of address space, only readable/writable if `commit`.
+local void* os_reserve(u64 size, b8 commit) {
+#if defined(__unix)
+    s32 flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    #if defined(MAP_NORESERVE)
+    if (!commit) flags |= MAP_NORESERVE;
+    #endif
+    void* ptr = mmap(NULL, size, commit ? PROT_READ | PROT_WRITE : PROT_NONE, flags, -1, 0);
+    return ptr == MAP_FAILED ? NULL : ptr;
+#else
+    return VirtualAlloc(NULL, size, commit ? MEM_RESERVE | MEM_COMMIT : MEM_RESERVE, commit ? PAGE_READWRITE : PAGE_NOACCESS);
+#endif
+}
+
+local b8 os_commit(void* ptr, u64 size) {
+#if defined(__unix)
+    return mprotect(ptr, size, PROT_READ | PROT_WRITE) == 0;
+#else
+    return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#endif
+}
+
+// Drops the physical pages behind a committed range, the range stays usable.
+local void os_decommit(void* ptr, u64 size, b8 lazy) {
+#if defined(__unix)
+    #if defined(MADV_FREE)
+    if (lazy && madvise(ptr, size, MADV_FREE) == 0) return;
+    #endif
+    madvise(ptr, size, MADV_DONTNEED);
+#else
+    (void)lazy;
+    VirtualAlloc(ptr, size, MEM_RESET, PAGE_READWRITE);
+#endif
+}
+
+// Like `os_decommit` but the range reads back as zeroes. Fails on pages the OS
+// won't drop (mlocked ranges, large pages), the caller then has to zero them.
+local b8 os_zero(void* ptr, u64 size) {
+#if defined(__unix)
+    return madvise(ptr, size, MADV_DONTNEED) == 0;
+#else
+    if (!VirtualFree(ptr, size, MEM_DECOMMIT)) return false;
+    return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#endif
+}
+
+local void os_release(void* ptr, u64 size) {
+#if defined(__unix)
+    munmap(ptr, size);
+#else
+    (void)size;
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#endif
+}
+
+// Maps a block for an arena, trying huge pages first when `ARENA_HUGE` is set.
+// Explicit huge pages can't be committed lazily so reserve-only blocks go
+// straight to transparent huge pages.
+local void* arena_map(u64 cap, b8 commit, u32 flags, u32* backing) {
+    *backing = ARENA_BACKING_PAGES;
+    if (!(flags & ARENA_HUGE)) return os_reserve(cap, commit);
+
+#if defined(__unix)
+    #if defined(MAP_HUGETLB)
+    u64 hugetlb = os_hugetlb_page_size();
+    if (commit && hugetlb != 0 && cap % hugetlb == 0) {
+        void* ptr = mmap(NULL, cap, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (ptr != MAP_FAILED) {
+            *backing = ARENA_BACKING_HUGETLB;
+            return ptr;
+        }
+    }
+    #endif
+
+    // Over-reserve so the block can be trimmed to a huge page boundary.
+    u64 huge = arena_huge_page_size();
+    u8* raw  = os_reserve(cap + huge, commit);
+    if (raw == NULL) return NULL;
+    u8* ptr = (u8*)align_up((u64)raw, huge);
+    if (ptr > raw) munmap(raw, ptr - raw);
+    munmap(ptr + cap, raw + huge - ptr);
+    #if defined(MADV_HUGEPAGE)
+    // The advice is accepted even when THP is switched off.
+    if (madvise(ptr, cap, MADV_HUGEPAGE) == 0 && os_thp_enabled()) *backing = ARENA_BACKING_THP;
+    #endif
+    return ptr;
+#else
+    u64 large_page = os_hugetlb_page_size();
+    if (commit && large_page != 0 && cap % large_page == 0) {
+        void* ptr = VirtualAlloc(NULL, cap, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (ptr != NULL) {
+            *backing = ARENA_BACKING_HUGETLB;
+            return ptr;
+        }
+    }
+    return os_reserve(cap, commit);
+#endif
+}
+
 Arena arena_new(u64 cap) {
+    return arena_new_ex(cap, 0, 0);
+}
+
+Arena arena_new_ex(u64 cap, u64 commit_size, u32 flags) {
     if (cap < KB(4)) cap = KB(4);
+    u64 granularity = (flags & ARENA_HUGE) ? arena_huge_page_size() : os_page_size();
+    if (flags & ARENA_HUGE) cap = align_up(cap, granularity);
+    if (commit_size != 0) commit_size = align_up(commit_size, granularity);
+    u64 commit = commit_size == 0 ? cap : MIN(commit_size, cap);
+
+    u32   backing;
+    void* buffer = arena_map(cap, commit_size == 0, flags, &backing);
+    if (buffer != NULL && commit_size != 0 && !os_commit(buffer, commit)) {
+        os_release(buffer, cap);
+        buffer = NULL;
+    }
+
     return (Arena) {
-#if defined(__unix)
-		.buffer = mmap(NULL, cap, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0),
+        .buffer      = buffer,
+        .pos         = 0,
+        .cap         = buffer ? cap : 0,
+        .commit      = buffer ? commit : 0,
+        .commit_size = commit_size,
+        .base        = 0,
+        .prev        = NULL,
+        .retain      = MAX_U64,
+        .flags       = flags,
+        .backing     = backing,
+    };
+}
+
+local b8 arena_commit(Arena* a, u64 end) {
+    u64 commit = MIN(align_up(end, a->commit_size), a->cap);
+    if (!os_commit((u8*)a->buffer + a->commit, commit - a->commit)) return false;
+    a->commit = commit;
+    return true;
+}
+
+// Moves `a` to a fresh block big enough for `size` bytes, the state of the
+// current block is saved at the start of the new one.
+local b8 arena_chain(Arena* a, u64 size) {
+    u64 granularity = (a->flags & ARENA_HUGE) ? arena_huge_page_size() : os_page_size();
+    u64 cap         = MAX(a->cap, align_up(ARENA_HEADER_SIZE + size, granularity));
+    u64 commit      = a->commit_size == 0 ? cap : MIN(align_up(ARENA_HEADER_SIZE + size, a->commit_size), cap);
+
+    u32 backing;
+    u8* block = arena_map(cap, a->commit_size == 0, a->flags, &backing);
+    if (block == NULL) return false;
+    if (a->commit_size != 0 && !os_commit(block, commit)) {
+        os_release(block, cap);
+        return false;
+    }
+
+    Arena* prev = (Arena*)block;
+    *prev       = *a;
+    a->buffer   = block;
+    a->pos      = ARENA_HEADER_SIZE;
+    a->cap      = cap;
+    a->commit   = commit;
+    a->base     = prev->base + prev->pos;
+    a->prev     = prev;
+    a->peak     = 0;
+    a->backing  = backing;
+    return true;
+}
+
+local void arena_unchain(Arena* a) {
+    Arena prev = *a->prev;
+    ARENA_STAT(ArenaStats stats = a->stats);
+    os_release(a->buffer, a->cap);
+    *a = prev;
+    ARENA_STAT(a->stats = stats);
+}
+
+void* arena_alloc(Arena* a, u64 size, u64 alignment) {
+    if (a->flags & ARENA_READONLY) {
+        ARENA_STAT(a->stats.failed += 1);
+        return NULL;
+    }
+    u64 start = align_up((u64)a->buffer + a->pos, alignment) - (u64)a->buffer;
+    u64 end   = start + size;
+    if (end > a->cap) {
+        if (!(a->flags & ARENA_GROW) || !arena_chain(a, size + alignment)) {
+            ARENA_STAT(a->stats.failed += 1);
+            return NULL;
+        }
+        start = align_up((u64)a->buffer + a->pos, alignment) - (u64)a->buffer;
+        end   = start + size;
+    }
+    if (end > a->commit && !arena_commit(a, end)) {
+        ARENA_STAT(a->stats.failed += 1);
+        return NULL;
+    }
+    ARENA_STAT(a->stats.allocs += 1);
+    ARENA_STAT(a->stats.requested += size);
+    ARENA_STAT(a->stats.padding += start - a->pos);
+    a->pos = end;
+
+    return (u8*)a->buffer + start;
+}
+
+#if defined(SAMLIB_ARENA_STATS)
+    #define ARENA_CALLSITE_COUNT 4096
+
+typedef struct {
+    const Arena* arena;
+    const char*  file;
+    u32          line;
+    u64          allocs;
+    u64          bytes;
+} ArenaCallsite;
+
+global ArenaCallsite arena_callsites[ARENA_CALLSITE_COUNT];
+global u32           arena_callsites_lock;
+global u64           arena_callsites_dropped; // Records lost to a full table.
+
+// Slots of freed arenas keep their `file` so probe chains stay intact, and are
+// taken over by the next callsite that passes them without finding its own.
+local void arena_callsite_add(const Arena* a, const char* file, u32 line, u64 size) {
+    u64 hash = ((u64)file ^ ((u64)line << 32) ^ (u64)a) * 0x9e3779b97f4a7c15ull;
+    spin_lock(&arena_callsites_lock);
+    ArenaCallsite* found = NULL;
+    ArenaCallsite* free  = NULL;
+    for (u64 i = 0; i < ARENA_CALLSITE_COUNT; i++) {
+        ArenaCallsite* site = &arena_callsites[((hash >> 52) + i) & (ARENA_CALLSITE_COUNT - 1)];
+        if (site->file == NULL) {
+            if (free == NULL) free = site;
+            break;
+        }
+        if (site->arena == NULL) {
+            if (free == NULL) free = site;
+        } else if (site->arena == a && site->file == file && site->line == line) {
+            found = site;
+            break;
+        }
+    }
+    if (found == NULL && free != NULL) {
+        *free = (ArenaCallsite) { .arena = a, .file = file, .line = line };
+        found = free;
+    }
+    if (found != NULL) {
+        found->allocs += 1;
+        found->bytes  += size;
+    } else {
+        arena_callsites_dropped += 1;
+    }
+    spin_unlock(&arena_callsites_lock);
+}
+
+// Detaches the callsites of a freed arena so their slots can be reused.
+local void arena_callsites_forget(const Arena* a) {
+    spin_lock(&arena_callsites_lock);
+    for (u64 i = 0; i < ARENA_CALLSITE_COUNT; i++) {
+        if (arena_callsites[i].arena == a) arena_callsites[i].arena = NULL;
+    }
+    spin_unlock(&arena_callsites_lock);
+}
+
+local void atomic_add_u64(u64* ptr, u64 val) {
+    #if defined(_MSC_VER)
+    _InterlockedExchangeAdd64((volatile long long*)ptr, (long long)val);
+    #else
+    __atomic_fetch_add(ptr, val, __ATOMIC_RELAXED);
+    #endif
+}
+#endif
+
+void* arena_alloc_tagged(Arena* a, u64 size, u64 alignment, const char* file, u32 line) {
+    void* ptr = arena_alloc(a, size, alignment);
+#if defined(SAMLIB_ARENA_STATS)
+    if (ptr != NULL) arena_callsite_add(a, file, line, size);
 #else
-		.buffer = VirtualAlloc(NULL, cap, MEM_COMMIT, PAGE_READWRITE),
+    (void)file;
+    (void)line;
 #endif
-		.pos = 0,
-		.cap = cap,
-	};
+    return ptr;
 }
 
-void* arena_alloc(Arena* a, u64 size, u64 alignment) {
-	void* unaligned_ptr = (u8*)a->buffer + a->pos;
-    void* ptr = (void*)(alignment * (((u64)unaligned_ptr + alignment - 1) / alignment));
+void arena_stats_report(const Arena* a, FILE* out) {
+#if defined(SAMLIB_ARENA_STATS)
+    fprintf(out,
+            "Arena %p: %llu allocs, %llu bytes requested, %llu bytes padding, high water %llu (block cap %llu), "
+            "%llu failed\n",
+            (void*)a,
+            a->stats.allocs,
+            a->stats.requested,
+            a->stats.padding,
+            MAX(a->stats.high_water, arena_pos(a)),
+            a->cap,
+            a->stats.failed);
+    spin_lock(&arena_callsites_lock);
+    for (u64 i = 0; i < ARENA_CALLSITE_COUNT; i++) {
+        const ArenaCallsite* site = &arena_callsites[i];
+        if (site->arena != a) continue;
+        fprintf(out, "    %s:%u: %llu allocs, %llu bytes\n", site->file, site->line, site->allocs, site->bytes);
+    }
+    if (arena_callsites_dropped > 0) {
+        fprintf(out, "    %llu allocations (all arenas) not attributed, callsite table full\n", arena_callsites_dropped);
+    }
+    spin_unlock(&arena_callsites_lock);
+#else
+    fprintf(out, "Arena %p: statistics disabled, build with SAMLIB_ARENA_STATS\n", (void*)a);
+#endif
+}
 
-    u64 end = (u64)ptr - (u64)a->buffer + size;
-    if (end > a->cap) return NULL;
-	a->pos = end;
+void* arena_realloc(Arena* a, void* ptr, u64 old_size, u64 new_size, u64 alignment) {
+    if (ptr == NULL || (a->flags & ARENA_READONLY)) return arena_alloc(a, new_size, alignment);
 
-	return ptr;
+    u64 start = (u64)ptr - (u64)a->buffer;
+    if ((u8*)ptr + old_size == (u8*)a->buffer + a->pos && start + new_size <= a->cap) {
+        u64 end = start + new_size;
+        if (end > a->commit && !arena_commit(a, end)) return NULL;
+        a->peak = MAX(a->peak, a->pos);
+        a->pos  = end;
+        return ptr;
+    }
+
+    void* new_ptr = arena_alloc(a, new_size, alignment);
+    if (new_ptr != NULL) memcpy(new_ptr, ptr, MIN(old_size, new_size));
+    return new_ptr;
+}
+
+// Commits up to `end` while other threads may be doing the same, committing a
+// range twice is harmless so only the published `commit` needs a CAS.
+local b8 arena_commit_atomic(Arena* a, u64 end) {
+    u64 commit = atomic_load_u64(&a->commit);
+    if (end <= commit) return true;
+
+    u64 target = MIN(align_up(end, a->commit_size), a->cap);
+    if (!os_commit((u8*)a->buffer + commit, target - commit)) return false;
+    while (commit < target && !atomic_cas_u64(&a->commit, &commit, target)) {}
+    return true;
+}
+
+void* arena_alloc_atomic(Arena* a, u64 size, u64 alignment) {
+    if (a->flags & ARENA_READONLY) {
+        ARENA_STAT(atomic_add_u64(&a->stats.failed, 1));
+        return NULL;
+    }
+    u64 pos = atomic_load_u64(&a->pos);
+    u64 start, end;
+    do {
+        start = align_up((u64)a->buffer + pos, alignment) - (u64)a->buffer;
+        end   = start + size;
+        if (end > a->cap) {
+            ARENA_STAT(atomic_add_u64(&a->stats.failed, 1));
+            return NULL;
+        }
+    } while (!atomic_cas_u64(&a->pos, &pos, end));
+
+    if (end > atomic_load_u64(&a->commit) && !arena_commit_atomic(a, end)) {
+        ARENA_STAT(atomic_add_u64(&a->stats.failed, 1));
+        return NULL;
+    }
+    ARENA_STAT(atomic_add_u64(&a->stats.allocs, 1));
+    ARENA_STAT(atomic_add_u64(&a->stats.requested, size));
+    ARENA_STAT(atomic_add_u64(&a->stats.padding, start - pos));
+    return (u8*)a->buffer + start;
+}
+
+Arena arena_slab(Arena* shared, u64 size) {
+    void* buffer = arena_alloc_atomic(shared, size, 64);
+    return (Arena) {
+        .buffer = buffer,
+        .pos    = 0,
+        .cap    = buffer ? size : 0,
+        .commit = buffer ? size : 0,
+        .retain = MAX_U64,
+        .flags  = ARENA_BORROWED,
+    };
 }
 
 void* arena_pop(Arena* a, u64 size) {
-    a->pos -= size;
+    arena_pop_to(a, arena_pos(a) - size);
     return (u8*)a->buffer + a->pos;
 }
 
-void arena_reset(Arena* a) { a->pos = 0; }
+local u64 arena_granularity(const Arena* a) {
+    // Explicit huge pages can only be dropped whole.
+    if (a->backing == ARENA_BACKING_HUGETLB) return os_hugetlb_page_size();
+    return (a->flags & ARENA_HUGE) ? arena_huge_page_size() : os_page_size();
+}
+
+// Hands the pages between the retained size and the high-water mark back to
+// the OS.
+local void arena_trim(Arena* a) {
+    if (a->peak <= a->retain) return;
+
+    u64 granularity = arena_granularity(a);
+    u64 base        = (u64)a->buffer;
+    u64 keep        = align_up(base + MAX(a->pos, a->retain), granularity);
+    u64 end         = base + MIN(a->peak, a->commit);
+    end            -= end % granularity;
+    if (end > keep) os_decommit((void*)keep, end - keep, a->flags & ARENA_LAZY);
+    a->peak = a->pos;
+}
+
+void arena_pop_to(Arena* a, u64 pos) {
+    ARENA_STAT(a->stats.high_water = MAX(a->stats.high_water, arena_pos(a)));
+    while (a->prev != NULL && pos < a->base + ARENA_HEADER_SIZE) arena_unchain(a);
+    if (pos - a->base < a->pos) {
+        a->peak = MAX(a->peak, a->pos);
+        a->pos  = pos - a->base;
+        arena_trim(a);
+    }
+}
+
+u64 arena_pos(const Arena* a) {
+    return a->base + a->pos;
+}
+
+void arena_reset(Arena* a) { arena_pop_to(a, 0); }
 
 void arena_clear(Arena* a) {
-	memset(a->buffer, 0, a->pos);
-	a->pos = 0;
+    if (a->flags & ARENA_READONLY) return;
+    while (a->prev != NULL) arena_unchain(a);
+
+    u8* start = a->buffer;
+    u8* end   = start + a->pos;
+    if (a->pos >= KB(64) && !(a->flags & ARENA_MAPPED)) {
+        u64 granularity = arena_granularity(a);
+        u8* first = (u8*)align_up((u64)start, granularity);
+        u8* last  = end - (u64)end % granularity;
+        if (last > first) {
+            memset(start, 0, first - start);
+            if (!os_zero(first, last - first)) memset(first, 0, last - first);
+            start = last;
+        }
+    }
+    memset(start, 0, end - start);
+    a->peak = 0;
+    a->pos  = 0;
+}
+
+void arena_set_retain(Arena* a, u64 retain) {
+    a->retain = retain;
+    a->peak   = MAX(a->peak, a->pos);
+    arena_trim(a);
 }
 
 void arena_free(Arena* a) {
+    ARENA_STAT(arena_callsites_forget(a));
+    while (a->prev != NULL) arena_unchain(a);
+    if (a->flags & ARENA_MAPPED) {
+#if defined(__unix)
+        munmap((u8*)a->buffer - ARENA_SNAPSHOT_HEADER, a->map_size);
+#else
+        UnmapViewOfFile((u8*)a->buffer - ARENA_SNAPSHOT_HEADER);
+#endif
+    } else if (a->buffer != NULL && !(a->flags & ARENA_BORROWED)) {
+        os_release(a->buffer, a->cap);
+    }
+    a->buffer = NULL;
+    a->cap = 0;
+    a->pos = 0;
+    a->commit = 0;
+    a->map_size = 0;
+}
+
+#define ARENA_SNAPSHOT_MAGIC   0x414e455241534d53ull // "SMSARENA"
+#define ARENA_SNAPSHOT_VERSION 1
+
+// Padded to `ARENA_SNAPSHOT_HEADER` bytes in the file so the data stays page
+// aligned once mapped.
+typedef struct {
+    u64 magic;
+    u32 version;
+    u32 header_size;
+    u64 size;
+} ArenaSnapshot;
+
+b8 arena_save(const Arena* a, const char* path) {
+    if (a->prev != NULL) return false;
+
+    u8 header[ARENA_SNAPSHOT_HEADER] = { 0 };
+    ArenaSnapshot snapshot = {
+        .magic       = ARENA_SNAPSHOT_MAGIC,
+        .version     = ARENA_SNAPSHOT_VERSION,
+        .header_size = ARENA_SNAPSHOT_HEADER,
+        .size        = a->pos,
+    };
+    memcpy(header, &snapshot, sizeof(snapshot));
+
 #if defined(__unix)
-	munmap(a->buffer, a->cap);
+    s32 fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    const u8* chunks[2] = { header, a->buffer };
+    u64       sizes[2]  = { sizeof(header), a->pos };
+    b8        ok        = true;
+    for (u64 i = 0; i < 2 && ok; i++) {
+        while (sizes[i] > 0) {
+            ssize_t written = write(fd, chunks[i], sizes[i]);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) {
+                ok = false;
+                break;
+            }
+            chunks[i] += written;
+            sizes[i]  -= written;
+        }
+    }
+    return close(fd) == 0 && ok;
 #else
-	VirtualFree(a->buffer, 0, MEM_RELEASE);
+    HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    const u8* chunks[2] = { header, a->buffer };
+    u64       sizes[2]  = { sizeof(header), a->pos };
+    b8        ok        = true;
+    for (u64 i = 0; i < 2 && ok; i++) {
+        while (sizes[i] > 0) {
+            DWORD written = 0;
+            if (!WriteFile(file, chunks[i], (DWORD)MIN(sizes[i], MAX_U32), &written, NULL) || written == 0) {
+                ok = false;
+                break;
+            }
+            chunks[i] += written;
+            sizes[i]  -= written;
+        }
+    }
+    return CloseHandle(file) && ok;
 #endif
-	a->buffer = NULL;
-	a->cap = 0;
-	a->pos = 0;
 }
 
-TempArena temp_arena_begin(Arena* a) {
-	return (TempArena) {
-		.arena = a,
-		.pos   = a->pos,
-	};
-}
+Arena arena_load(const char* path, b8 copy_on_write) {
+    Arena a = { .retain = MAX_U64 };
+
+#if defined(__unix)
+    s32 fd = open(path, O_RDONLY);
+    if (fd < 0) return a;
+    struct stat st;
+    u8*         map  = MAP_FAILED;
+    u64         size = 0;
+    if (fstat(fd, &st) == 0 && (u64)st.st_size >= ARENA_SNAPSHOT_HEADER) {
+        size = st.st_size;
+        map  = mmap(NULL, size, copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) return a;
+#else
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return a;
+    LARGE_INTEGER file_size;
+    u8*           map  = NULL;
+    u64           size = 0;
+    if (GetFileSizeEx(file, &file_size) && (u64)file_size.QuadPart >= ARENA_SNAPSHOT_HEADER) {
+        size           = file_size.QuadPart;
+        HANDLE mapping = CreateFileMappingA(file, NULL, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL) {
+            map = MapViewOfFile(mapping, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+    if (map == NULL) return a;
+#endif
+
+    ArenaSnapshot snapshot;
+    memcpy(&snapshot, map, sizeof(snapshot));
+    if (snapshot.magic != ARENA_SNAPSHOT_MAGIC || snapshot.version != ARENA_SNAPSHOT_VERSION ||
+        snapshot.header_size != ARENA_SNAPSHOT_HEADER || snapshot.size > size - ARENA_SNAPSHOT_HEADER) {
+#if defined(__unix)
+        munmap(map, size);
+#else
+        UnmapViewOfFile(map);
+#endif
+        return a;
+    }
+
+    a.buffer   = map + ARENA_SNAPSHOT_HEADER;
+    a.pos      = snapshot.size;
+    a.cap      = snapshot.size;
+    a.commit   = snapshot.size;
+    a.map_size = size; // The file may run past the snapshot.
+    a.flags    = copy_on_write ? ARENA_MAPPED : ARENA_MAPPED | ARENA_READONLY;
+    return a;
+}
+
+TempArena temp_arena_begin(Arena* a) {
+    return (TempArena) {
+        .arena = a,
+        .pos   = arena_pos(a),
+    };
+}
+
+void temp_arena_end(TempArena temp) {
+    arena_pop_to(temp.arena, temp.pos);
+}
+
+local per_thread Arena scratch_arenas[SCRATCH_ARENA_COUNT];
+
+TempArena scratch_begin(Arena** conflicts, u64 count) {
+    for (u64 i = 0; i < SCRATCH_ARENA_COUNT; i++) {
+        Arena* a = &scratch_arenas[i];
+        b8 conflict = false;
+        for (u64 j = 0; j < count && !conflict; j++) conflict = (conflicts[j] == a);
+        if (conflict) continue;
+
+        if (a->buffer == NULL) *a = arena_reserve(DEFAULT_ARENA_SIZE);
+        return temp_arena_begin(a);
+    }
+    PANIC("Every scratch arena is in the conflict list\n");
+}
+
+void scratch_end(TempArena temp) {
+    temp_arena_end(temp);
+}
+
+void scratch_free(void) {
+    for (u64 i = 0; i < SCRATCH_ARENA_COUNT; i++) arena_free(&scratch_arenas[i]);
+}
+
+Pool pool_new(Arena* arena, u64 elem_size, u64 align) {
+    align     = MAX(align, alignof(void*));
+    elem_size = align_up(MAX(elem_size, sizeof(void*)), align);
+    return (Pool) {
+        .arena      = arena,
+        .slab_count = MAX(POOL_SLAB_SIZE / elem_size, 1),
+        .elem_size  = elem_size,
+        .align      = align,
+    };
+}
+
+void* pool_alloc(Pool* pool) {
+    void* ptr = pool->free_list;
+    if (ptr != NULL) {
+        pool->free_list = *(void**)ptr;
+        return ptr;
+    }
+
+    if (pool->slab_left == 0) {
+        pool->slab = arena_alloc(pool->arena, pool->elem_size * pool->slab_count, pool->align);
+        if (pool->slab == NULL) return NULL;
+        pool->slab_left = pool->slab_count;
+    }
+    ptr              = pool->slab;
+    pool->slab      += pool->elem_size;
+    pool->slab_left -= 1;
+    return ptr;
+}
+
+void pool_free(Pool* pool, void* ptr) {
+    if (ptr == NULL) return;
+    *(void**)ptr    = pool->free_list;
+    pool->free_list = ptr;
+}
+
+PoolCache pool_cache_new(Pool* pool) {
+    return (PoolCache) {
+        .pool = pool,
+    };
+}
+
+void* pool_cache_alloc(PoolCache* cache) {
+    if (cache->free_list == NULL) {
+        spin_lock(&cache->pool->lock);
+        for (u64 i = 0; i < POOL_CACHE_SIZE / 2; i++) {
+            void* ptr = pool_alloc(cache->pool);
+            if (ptr == NULL) break;
+            *(void**)ptr      = cache->free_list;
+            cache->free_list  = ptr;
+            cache->count     += 1;
+        }
+        spin_unlock(&cache->pool->lock);
+        if (cache->free_list == NULL) return NULL;
+    }
+
+    void* ptr         = cache->free_list;
+    cache->free_list  = *(void**)ptr;
+    cache->count     -= 1;
+    return ptr;
+}
+
+// Moves `count` objects from the cache back to its pool.
+local void pool_cache_release(PoolCache* cache, u64 count) {
+    spin_lock(&cache->pool->lock);
+    for (u64 i = 0; i < count && cache->free_list != NULL; i++) {
+        void* ptr         = cache->free_list;
+        cache->free_list  = *(void**)ptr;
+        cache->count     -= 1;
+        pool_free(cache->pool, ptr);
+    }
+    spin_unlock(&cache->pool->lock);
+}
+
+void pool_cache_free(PoolCache* cache, void* ptr) {
+    if (ptr == NULL) return;
+    *(void**)ptr      = cache->free_list;
+    cache->free_list  = ptr;
+    cache->count     += 1;
+    if (cache->count > POOL_CACHE_SIZE) pool_cache_release(cache, POOL_CACHE_SIZE / 2);
+}
+
+void pool_cache_flush(PoolCache* cache) {
+    pool_cache_release(cache, cache->count);
+}
+
+#define TLSF_ALIGN_LOG2  4
+#define TLSF_ALIGN       (1 << TLSF_ALIGN_LOG2)
+#define TLSF_SL_LOG2     5
+#define TLSF_SL_COUNT    (1 << TLSF_SL_LOG2)
+#define TLSF_FL_SHIFT    (TLSF_SL_LOG2 + TLSF_ALIGN_LOG2)
+#define TLSF_FL_MAX      40
+#define TLSF_FL_COUNT    (TLSF_FL_MAX - TLSF_FL_SHIFT + 1)
+#define TLSF_SMALL_BLOCK (1 << TLSF_FL_SHIFT)
+
+#define TLSF_FREE      1 // Block is free.
+#define TLSF_PREV_FREE 2 // Previous physical block is free, `prev_phys` is valid.
+#define TLSF_FLAGS     (TLSF_FREE | TLSF_PREV_FREE)
+
+typedef struct TlsfBlock {
+    struct TlsfBlock* prev_phys;
+    u64               size;      // Payload size, the low bits hold the flags.
+    struct TlsfBlock* next_free; // The free list links overlap the payload.
+    struct TlsfBlock* prev_free;
+} TlsfBlock;
+
+#define TLSF_HEADER   (sizeof(TlsfBlock*) + sizeof(u64))
+#define TLSF_MIN_SIZE (sizeof(TlsfBlock) - TLSF_HEADER)
+
+typedef struct TlsfRegion {
+    Arena              arena;
+    struct TlsfRegion* next;
+} TlsfRegion;
+
+struct Tlsf {
+    u32         fl_bitmap;
+    u32         sl_bitmap[TLSF_FL_COUNT];
+    TlsfBlock*  blocks[TLSF_FL_COUNT][TLSF_SL_COUNT];
+    TlsfRegion* regions;
+    u64         region_size;
+};
+
+local u64 tlsf_block_size(const TlsfBlock* block) {
+    return block->size & ~(u64)TLSF_FLAGS;
+}
+
+local TlsfBlock* tlsf_block_next(const TlsfBlock* block) {
+    return (TlsfBlock*)((u8*)block + TLSF_HEADER + tlsf_block_size(block));
+}
+
+local void tlsf_mapping(u64 size, u32* fl, u32* sl) {
+    if (size < TLSF_SMALL_BLOCK) {
+        *fl = 0;
+        *sl = (u32)size / (TLSF_SMALL_BLOCK / TLSF_SL_COUNT);
+    } else {
+        u32 msb = msb_index(size);
+        *sl     = (u32)(size >> (msb - TLSF_SL_LOG2)) ^ TLSF_SL_COUNT;
+        *fl     = msb - (TLSF_FL_SHIFT - 1);
+    }
+}
+
+// Rounds `size` up to the next list so any block found there fits.
+local u64 tlsf_round_size(u64 size) {
+    if (size >= TLSF_SMALL_BLOCK) size += ((u64)1 << (msb_index(size) - TLSF_SL_LOG2)) - 1;
+    return size;
+}
+
+local void tlsf_insert(Tlsf* t, TlsfBlock* block) {
+    u32 fl, sl;
+    tlsf_mapping(tlsf_block_size(block), &fl, &sl);
+    TlsfBlock* head  = t->blocks[fl][sl];
+    block->next_free = head;
+    block->prev_free = NULL;
+    if (head != NULL) head->prev_free = block;
+    t->blocks[fl][sl]  = block;
+    t->fl_bitmap      |= 1u << fl;
+    t->sl_bitmap[fl]  |= 1u << sl;
+}
+
+local void tlsf_remove(Tlsf* t, TlsfBlock* block) {
+    u32 fl, sl;
+    tlsf_mapping(tlsf_block_size(block), &fl, &sl);
+    if (block->next_free != NULL) block->next_free->prev_free = block->prev_free;
+    if (block->prev_free != NULL) {
+        block->prev_free->next_free = block->next_free;
+    } else {
+        t->blocks[fl][sl] = block->next_free;
+        if (block->next_free == NULL) {
+            t->sl_bitmap[fl] &= ~(1u << sl);
+            if (t->sl_bitmap[fl] == 0) t->fl_bitmap &= ~(1u << fl);
+        }
+    }
+}
+
+local TlsfBlock* tlsf_find(Tlsf* t, u64 size) {
+    u32 fl, sl;
+    tlsf_mapping(tlsf_round_size(size), &fl, &sl);
+    if (fl >= TLSF_FL_COUNT) return NULL;
+
+    u32 sl_map = t->sl_bitmap[fl] & (~0u << sl);
+    if (sl_map == 0) {
+        u32 fl_map = fl + 1 < 32 ? t->fl_bitmap & (~0u << (fl + 1)) : 0;
+        if (fl_map == 0) return NULL;
+        fl     = lsb_index(fl_map);
+        sl_map = t->sl_bitmap[fl];
+    }
+    return t->blocks[fl][lsb_index(sl_map)];
+}
+
+// Turns the memory left in `arena` into one free block followed by a used,
+// zero-sized sentinel that stops merges at the end of the region.
+local void tlsf_add_block(Tlsf* t, Arena* arena) {
+    u64 start = align_up((u64)arena->buffer + arena->pos, TLSF_ALIGN);
+    u64 end   = ((u64)arena->buffer + arena->cap) & ~(u64)(TLSF_ALIGN - 1);
+    arena->pos = arena->cap;
+
+    TlsfBlock* block    = (TlsfBlock*)start;
+    block->size         = (end - start - 2 * TLSF_HEADER) | TLSF_FREE;
+    TlsfBlock* sentinel = tlsf_block_next(block);
+    sentinel->prev_phys = block;
+    sentinel->size      = TLSF_PREV_FREE;
+    tlsf_insert(t, block);
+}
+
+local b8 tlsf_add_region(Tlsf* t, u64 size) {
+    u64   cap   = MAX(t->region_size, tlsf_round_size(size) + sizeof(TlsfRegion) + 3 * TLSF_HEADER + TLSF_ALIGN);
+    Arena arena = arena_new(cap);
+    if (arena.buffer == NULL) return false;
+
+    TlsfRegion* region = push_type(&arena, TlsfRegion);
+    region->arena      = arena;
+    region->next       = t->regions;
+    t->regions         = region;
+    tlsf_add_block(t, &region->arena);
+    return true;
+}
+
+// Marks a free block as used, giving back whatever is left past `size`.
+local void tlsf_use(Tlsf* t, TlsfBlock* block, u64 size) {
+    u64 total = tlsf_block_size(block);
+    if (total >= size + TLSF_HEADER + TLSF_MIN_SIZE) {
+        TlsfBlock* rest = (TlsfBlock*)((u8*)block + TLSF_HEADER + size);
+        rest->size      = (total - size - TLSF_HEADER) | TLSF_FREE;
+        block->size     = size | (block->size & TLSF_PREV_FREE);
+        TlsfBlock* next = tlsf_block_next(rest);
+        next->prev_phys = rest;
+        tlsf_insert(t, rest);
+    } else {
+        block->size &= ~(u64)TLSF_FREE;
+        tlsf_block_next(block)->size &= ~(u64)TLSF_PREV_FREE;
+    }
+}
+
+Tlsf* tlsf_new(u64 cap) {
+    Arena arena = arena_new(cap);
+    if (arena.buffer == NULL) return NULL;
+
+    Tlsf*       t      = push_type(&arena, Tlsf);
+    TlsfRegion* region = push_type(&arena, TlsfRegion);
+    memset(t, 0, sizeof(Tlsf));
+    region->arena  = arena;
+    region->next   = NULL;
+    t->regions     = region;
+    t->region_size = arena.cap;
+    tlsf_add_block(t, &region->arena);
+    return t;
+}
+
+void* tlsf_alloc(Tlsf* t, u64 size) {
+    if (size == 0) return NULL;
+    size = align_up(MAX(size, TLSF_MIN_SIZE), TLSF_ALIGN);
+
+    TlsfBlock* block = tlsf_find(t, size);
+    if (block == NULL) {
+        if (!tlsf_add_region(t, size)) return NULL;
+        block = tlsf_find(t, size);
+        if (block == NULL) return NULL;
+    }
+    tlsf_remove(t, block);
+    tlsf_use(t, block, size);
+    return (u8*)block + TLSF_HEADER;
+}
+
+void* tlsf_realloc(Tlsf* t, void* ptr, u64 size) {
+    if (ptr == NULL) return tlsf_alloc(t, size);
+    if (size == 0) {
+        tlsf_free(t, ptr);
+        return NULL;
+    }
+
+    TlsfBlock* block  = (TlsfBlock*)((u8*)ptr - TLSF_HEADER);
+    TlsfBlock* next   = tlsf_block_next(block);
+    u64        cur    = tlsf_block_size(block);
+    u64        adjust = align_up(MAX(size, TLSF_MIN_SIZE), TLSF_ALIGN);
+    if (adjust > cur && (next->size & TLSF_FREE) && cur + TLSF_HEADER + tlsf_block_size(next) >= adjust) {
+        tlsf_remove(t, next);
+        cur         += TLSF_HEADER + tlsf_block_size(next);
+        block->size  = cur | (block->size & TLSF_PREV_FREE);
+        tlsf_block_next(block)->size &= ~(u64)TLSF_PREV_FREE;
+    }
+
+    if (adjust <= cur) {
+        // Split off the tail as a used block and free it so it merges with
+        // whatever follows.
+        if (cur >= adjust + TLSF_HEADER + TLSF_MIN_SIZE) {
+            TlsfBlock* rest = (TlsfBlock*)((u8*)block + TLSF_HEADER + adjust);
+            rest->size      = cur - adjust - TLSF_HEADER;
+            block->size     = adjust | (block->size & TLSF_PREV_FREE);
+            tlsf_free(t, (u8*)rest + TLSF_HEADER);
+        }
+        return ptr;
+    }
+
+    void* new_ptr = tlsf_alloc(t, size);
+    if (new_ptr == NULL) return NULL;
+    memcpy(new_ptr, ptr, cur);
+    tlsf_free(t, ptr);
+    return new_ptr;
+}
+
+void tlsf_free(Tlsf* t, void* ptr) {
+    if (ptr == NULL) return;
+
+    TlsfBlock* block = (TlsfBlock*)((u8*)ptr - TLSF_HEADER);
+    u64        size  = tlsf_block_size(block);
+    if (block->size & TLSF_PREV_FREE) {
+        TlsfBlock* prev = block->prev_phys;
+        tlsf_remove(t, prev);
+        size  += TLSF_HEADER + tlsf_block_size(prev);
+        block  = prev;
+    }
+    TlsfBlock* next = (TlsfBlock*)((u8*)block + TLSF_HEADER + size);
+    if (next->size & TLSF_FREE) {
+        tlsf_remove(t, next);
+        size += TLSF_HEADER + tlsf_block_size(next);
+        next  = (TlsfBlock*)((u8*)block + TLSF_HEADER + size);
+    }
+
+    block->size      = size | TLSF_FREE | (block->size & TLSF_PREV_FREE);
+    next->prev_phys  = block;
+    next->size      |= TLSF_PREV_FREE;
+    tlsf_insert(t, block);
+}
+
+void tlsf_destroy(Tlsf* t) {
+    TlsfRegion* region = t->regions;
+    while (region != NULL) {
+        TlsfRegion* next  = region->next;
+        Arena       arena = region->arena;
+        arena_free(&arena);
+        region = next;
+    }
+}
+
+String string_init(u8* buffer) {
+    return (String) {
+        .buffer = buffer,
+        .length = 0,
+    };
+}
+
+void string_write_str(String* str, const char* s) {
+    u64 length = 0;
+    while (s[length]) length += 1;
+    memcpy(str->buffer + str->length, s, length);
+    str->length += length;
+}
+
+local const char digit_pairs[201] = "00010203040506070809"
+                                    "10111213141516171819"
+                                    "20212223242526272829"
+                                    "30313233343536373839"
+                                    "40414243444546474849"
+                                    "50515253545556575859"
+                                    "60616263646566676869"
+                                    "70717273747576777879"
+                                    "80818283848586878889"
+                                    "90919293949596979899";
+
+local const u64 digit_powers[20] = {
+    0,
+    10ull,
+    100ull,
+    1000ull,
+    10000ull,
+    100000ull,
+    1000000ull,
+    10000000ull,
+    100000000ull,
+    1000000000ull,
+    10000000000ull,
+    100000000000ull,
+    1000000000000ull,
+    10000000000000ull,
+    100000000000000ull,
+    1000000000000000ull,
+    10000000000000000ull,
+    100000000000000000ull,
+    1000000000000000000ull,
+    10000000000000000000ull,
+};
+
+// Decimal digits of `val`: log10 estimated from the bit length and corrected
+// with one table lookup.
+local u32 count_digits(u64 val) {
+    u32 t = ((msb_index(val | 1) + 1) * 1233) >> 12;
+    return t + 1 - (val < digit_powers[t]);
+}
+
+// Writes `val` in decimal, two digits per division, and returns the length.
+local u32 write_digits(u8* out, u64 val) {
+    u32 length = count_digits(val);
+    u8* ptr    = out + length;
+    while (val >= 100) {
+        u64 quot  = val / 100;
+        u32 rem   = (u32)(val - quot * 100);
+        ptr      -= 2;
+        memcpy(ptr, digit_pairs + 2 * rem, 2);
+        val = quot;
+    }
+    if (val >= 10) {
+        memcpy(ptr - 2, digit_pairs + 2 * val, 2);
+    } else {
+        ptr[-1] = '0' + (u8)val;
+    }
+    return length;
+}
+
+local void string_write_signed(String* str, s64 val) {
+    u64 magnitude = (u64)val;
+    if (val < 0) {
+        str->buffer[str->length] = '-';
+        str->length += 1;
+        magnitude = 0 - magnitude;
+    }
+    str->length += write_digits(str->buffer + str->length, magnitude);
+}
+
+local void string_write_unsigned(String* str, u64 val) {
+    str->length += write_digits(str->buffer + str->length, val);
+}
+
+void string_write_s8(String* str, s8 val) { string_write_signed(str, val); }
+
+void string_write_s16(String* str, s16 val) { string_write_signed(str, val); }
+
+void string_write_s32(String* str, s32 val) { string_write_signed(str, val); }
+
+void string_write_s64(String* str, s64 val) { string_write_signed(str, val); }
+
+void string_write_u8(String* str, u8 val) { string_write_unsigned(str, val); }
+
+void string_write_u16(String* str, u16 val) { string_write_unsigned(str, val); }
+
+void string_write_u32(String* str, u32 val) { string_write_unsigned(str, val); }
+
+void string_write_u64(String* str, u64 val) { string_write_unsigned(str, val); }
+
+void string_write_hex(String* str, u64 val) {
+    persist const char hex[] = "0123456789abcdef";
+    u32 length = msb_index(val | 1) / 4 + 1;
+    u8* ptr    = str->buffer + str->length + length;
+    for (u32 i = 0; i < length; i++) {
+        *--ptr  = hex[val & 0xf];
+        val   >>= 4;
+    }
+    str->length += length;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                              FLOAT FORMATTING                             */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Shortest round-trip digits with Ryu (Ulf Adams, 2018). f32 runs through the
+// same f64 tables, its mantissa is small enough for their precision.
+
+#define RYU_POW5_INV_BITCOUNT   125
+#define RYU_POW5_BITCOUNT       125
+#define RYU_POW5_INV_TABLE_SIZE 342
+#define RYU_POW5_TABLE_SIZE     326
+
+local const u64 ryu_pow5_inv_split[RYU_POW5_INV_TABLE_SIZE][2] = {
+    { 1ull, 2305843009213693952ull },
+    { 11068046444225730970ull, 1844674407370955161ull },
+    { 5165088340638674453ull, 1475739525896764129ull },
+    { 7821419487252849886ull, 1180591620717411303ull },
+    { 8824922364862649494ull, 1888946593147858085ull },
+    { 7059937891890119595ull, 1511157274518286468ull },
+    { 13026647942995916322ull, 1208925819614629174ull },
+    { 9774590264567735146ull, 1934281311383406679ull },
+    { 11509021026396098440ull, 1547425049106725343ull },
+    { 16585914450600699399ull, 1237940039285380274ull },
+    { 15469416676735388068ull, 1980704062856608439ull },
+    { 16064882156130220778ull, 1584563250285286751ull },
+    { 9162556910162266299ull, 1267650600228229401ull },
+    { 7281393426775805432ull, 2028240960365167042ull },
+    { 16893161185646375315ull, 1622592768292133633ull },
+    { 2446482504291369283ull, 1298074214633706907ull },
+    { 7603720821608101175ull, 2076918743413931051ull },
+    { 2393627842544570617ull, 1661534994731144841ull },
+    { 16672297533003297786ull, 1329227995784915872ull },
+    { 11918280793837635165ull, 2126764793255865396ull },
+    { 5845275820328197809ull, 1701411834604692317ull },
+    { 15744267100488289217ull, 1361129467683753853ull },
+    { 3054734472329800808ull, 2177807148294006166ull },
+    { 17201182836831481939ull, 1742245718635204932ull },
+    { 6382248639981364905ull, 1393796574908163946ull },
+    { 2832900194486363201ull, 2230074519853062314ull },
+    { 5955668970331000884ull, 1784059615882449851ull },
+    { 1075186361522890384ull, 1427247692705959881ull },
+    { 12788344622662355584ull, 2283596308329535809ull },
+    { 13920024512871794791ull, 1826877046663628647ull },
+    { 3757321980813615186ull, 1461501637330902918ull },
+    { 10384555214134712795ull, 1169201309864722334ull },
+    { 5547241898389809503ull, 1870722095783555735ull },
+    { 4437793518711847602ull, 1496577676626844588ull },
+    { 10928932444453298728ull, 1197262141301475670ull },
+    { 17486291911125277965ull, 1915619426082361072ull },
+    { 6610335899416401726ull, 1532495540865888858ull },
+    { 12666966349016942027ull, 1225996432692711086ull },
+    { 12888448528943286597ull, 1961594292308337738ull },
+    { 17689456452638449924ull, 1569275433846670190ull },
+    { 14151565162110759939ull, 1255420347077336152ull },
+    { 7885109000409574610ull, 2008672555323737844ull },
+    { 9997436015069570011ull, 1606938044258990275ull },
+    { 7997948812055656009ull, 1285550435407192220ull },
+    { 12796718099289049614ull, 2056880696651507552ull },
+    { 2858676849947419045ull, 1645504557321206042ull },
+    { 13354987924183666206ull, 1316403645856964833ull },
+    { 17678631863951955605ull, 2106245833371143733ull },
+    { 3074859046935833515ull, 1684996666696914987ull },
+    { 13527933681774397782ull, 1347997333357531989ull },
+    { 10576647446613305481ull, 2156795733372051183ull },
+    { 15840015586774465031ull, 1725436586697640946ull },
+    { 8982663654677661702ull, 1380349269358112757ull },
+    { 18061610662226169046ull, 2208558830972980411ull },
+    { 10759939715039024913ull, 1766847064778384329ull },
+    { 12297300586773130254ull, 1413477651822707463ull },
+    { 15986332124095098083ull, 2261564242916331941ull },
+    { 9099716884534168143ull, 1809251394333065553ull },
+    { 14658471137111155161ull, 1447401115466452442ull },
+    { 4348079280205103483ull, 1157920892373161954ull },
+    { 14335624477811986218ull, 1852673427797059126ull },
+    { 7779150767507678651ull, 1482138742237647301ull },
+    { 2533971799264232598ull, 1185710993790117841ull },
+    { 15122401323048503126ull, 1897137590064188545ull },
+    { 12097921058438802501ull, 1517710072051350836ull },
+    { 5988988032009131678ull, 1214168057641080669ull },
+    { 16961078480698431330ull, 1942668892225729070ull },
+    { 13568862784558745064ull, 1554135113780583256ull },
+    { 7165741412905085728ull, 1243308091024466605ull },
+    { 11465186260648137165ull, 1989292945639146568ull },
+    { 16550846638002330379ull, 1591434356511317254ull },
+    { 16930026125143774626ull, 1273147485209053803ull },
+    { 4951948911778577463ull, 2037035976334486086ull },
+    { 272210314680951647ull, 1629628781067588869ull },
+    { 3907117066486671641ull, 1303703024854071095ull },
+    { 6251387306378674625ull, 2085924839766513752ull },
+    { 16069156289328670670ull, 1668739871813211001ull },
+    { 9165976216721026213ull, 1334991897450568801ull },
+    { 7286864317269821294ull, 2135987035920910082ull },
+    { 16897537898041588005ull, 1708789628736728065ull },
+    { 13518030318433270404ull, 1367031702989382452ull },
+    { 6871453250525591353ull, 2187250724783011924ull },
+    { 9186511415162383406ull, 1749800579826409539ull },
+    { 11038557946871817048ull, 1399840463861127631ull },
+    { 10282995085511086630ull, 2239744742177804210ull },
+    { 8226396068408869304ull, 1791795793742243368ull },
+    { 13959814484210916090ull, 1433436634993794694ull },
+    { 11267656730511734774ull, 2293498615990071511ull },
+    { 5324776569667477496ull, 1834798892792057209ull },
+    { 7949170070475892320ull, 1467839114233645767ull },
+    { 17427382500606444826ull, 1174271291386916613ull },
+    { 5747719112518849781ull, 1878834066219066582ull },
+    { 15666221734240810795ull, 1503067252975253265ull },
+    { 12532977387392648636ull, 1202453802380202612ull },
+    { 5295368560860596524ull, 1923926083808324180ull },
+    { 4236294848688477220ull, 1539140867046659344ull },
+    { 7078384693692692099ull, 1231312693637327475ull },
+    { 11325415509908307358ull, 1970100309819723960ull },
+    { 9060332407926645887ull, 1576080247855779168ull },
+    { 14626963555825137356ull, 1260864198284623334ull },
+    { 12335095245094488799ull, 2017382717255397335ull },
+    { 9868076196075591040ull, 1613906173804317868ull },
+    { 15273158586344293478ull, 1291124939043454294ull },
+    { 13369007293925138595ull, 2065799902469526871ull },
+    { 7005857020398200553ull, 1652639921975621497ull },
+    { 16672732060544291412ull, 1322111937580497197ull },
+    { 11918976037903224966ull, 2115379100128795516ull },
+    { 5845832015580669650ull, 1692303280103036413ull },
+    { 12055363241948356366ull, 1353842624082429130ull },
+    { 841837113407818570ull, 2166148198531886609ull },
+    { 4362818505468165179ull, 1732918558825509287ull },
+    { 14558301248600263113ull, 1386334847060407429ull },
+    { 12225235553534690011ull, 2218135755296651887ull },
+    { 2401490813343931363ull, 1774508604237321510ull },
+    { 1921192650675145090ull, 1419606883389857208ull },
+    { 17831303500047873437ull, 2271371013423771532ull },
+    { 6886345170554478103ull, 1817096810739017226ull },
+    { 1819727321701672159ull, 1453677448591213781ull },
+    { 16213177116328979020ull, 1162941958872971024ull },
+    { 14873036941900635463ull, 1860707134196753639ull },
+    { 15587778368262418694ull, 1488565707357402911ull },
+    { 8780873879868024632ull, 1190852565885922329ull },
+    { 2981351763563108441ull, 1905364105417475727ull },
+    { 13453127855076217722ull, 1524291284333980581ull },
+    { 7073153469319063855ull, 1219433027467184465ull },
+    { 11317045550910502167ull, 1951092843947495144ull },
+    { 12742985255470312057ull, 1560874275157996115ull },
+    { 10194388204376249646ull, 1248699420126396892ull },
+    { 1553625868034358140ull, 1997919072202235028ull },
+    { 8621598323911307159ull, 1598335257761788022ull },
+    { 17965325103354776697ull, 1278668206209430417ull },
+    { 13987124906400001422ull, 2045869129935088668ull },
+    { 121653480894270168ull, 1636695303948070935ull },
+    { 97322784715416134ull, 1309356243158456748ull },
+    { 14913111714512307107ull, 2094969989053530796ull },
+    { 8241140556867935363ull, 1675975991242824637ull },
+    { 17660958889720079260ull, 1340780792994259709ull },
+    { 17189487779326395846ull, 2145249268790815535ull },
+    { 13751590223461116677ull, 1716199415032652428ull },
+    { 18379969808252713988ull, 1372959532026121942ull },
+    { 14650556434236701088ull, 2196735251241795108ull },
+    { 652398703163629901ull, 1757388200993436087ull },
+    { 11589965406756634890ull, 1405910560794748869ull },
+    { 7475898206584884855ull, 2249456897271598191ull },
+    { 2291369750525997561ull, 1799565517817278553ull },
+    { 9211793429904618695ull, 1439652414253822842ull },
+    { 18428218302589300235ull, 2303443862806116547ull },
+    { 7363877012587619542ull, 1842755090244893238ull },
+    { 13269799239553916280ull, 1474204072195914590ull },
+    { 10615839391643133024ull, 1179363257756731672ull },
+    { 2227947767661371545ull, 1886981212410770676ull },
+    { 16539753473096738529ull, 1509584969928616540ull },
+    { 13231802778477390823ull, 1207667975942893232ull },
+    { 6413489186596184024ull, 1932268761508629172ull },
+    { 16198837793502678189ull, 1545815009206903337ull },
+    { 5580372605318321905ull, 1236652007365522670ull },
+    { 8928596168509315048ull, 1978643211784836272ull },
+    { 18210923379033183008ull, 1582914569427869017ull },
+    { 7190041073742725760ull, 1266331655542295214ull },
+    { 436019273762630246ull, 2026130648867672343ull },
+    { 7727513048493924843ull, 1620904519094137874ull },
+    { 9871359253537050198ull, 1296723615275310299ull },
+    { 4726128361433549347ull, 2074757784440496479ull },
+    { 7470251503888749801ull, 1659806227552397183ull },
+    { 13354898832594820487ull, 1327844982041917746ull },
+    { 13989140502667892133ull, 2124551971267068394ull },
+    { 14880661216876224029ull, 1699641577013654715ull },
+    { 11904528973500979224ull, 1359713261610923772ull },
+    { 4289851098633925465ull, 2175541218577478036ull },
+    { 18189276137874781665ull, 1740432974861982428ull },
+    { 3483374466074094362ull, 1392346379889585943ull },
+    { 1884050330976640656ull, 2227754207823337509ull },
+    { 5196589079523222848ull, 1782203366258670007ull },
+    { 15225317707844309248ull, 1425762693006936005ull },
+    { 5913764258841343181ull, 2281220308811097609ull },
+    { 8420360221814984868ull, 1824976247048878087ull },
+    { 17804334621677718864ull, 1459980997639102469ull },
+    { 17932816512084085415ull, 1167984798111281975ull },
+    { 10245762345624985047ull, 1868775676978051161ull },
+    { 4507261061758077715ull, 1495020541582440929ull },
+    { 7295157664148372495ull, 1196016433265952743ull },
+    { 7982903447895485668ull, 1913626293225524389ull },
+    { 10075671573058298858ull, 1530901034580419511ull },
+    { 4371188443704728763ull, 1224720827664335609ull },
+    { 14372599139411386667ull, 1959553324262936974ull },
+    { 15187428126271019657ull, 1567642659410349579ull },
+    { 15839291315758726049ull, 1254114127528279663ull },
+    { 3206773216762499739ull, 2006582604045247462ull },
+    { 13633465017635730761ull, 1605266083236197969ull },
+    { 14596120828850494932ull, 1284212866588958375ull },
+    { 4907049252451240275ull, 2054740586542333401ull },
+    { 236290587219081897ull, 1643792469233866721ull },
+    { 14946427728742906810ull, 1315033975387093376ull },
+    { 16535586736504830250ull, 2104054360619349402ull },
+    { 5849771759720043554ull, 1683243488495479522ull },
+    { 15747863852001765813ull, 1346594790796383617ull },
+    { 10439186904235184007ull, 2154551665274213788ull },
+    { 15730047152871967852ull, 1723641332219371030ull },
+    { 12584037722297574282ull, 1378913065775496824ull },
+    { 9066413911450387881ull, 2206260905240794919ull },
+    { 10942479943902220628ull, 1765008724192635935ull },
+    { 8753983955121776503ull, 1412006979354108748ull },
+    { 10317025513452932081ull, 2259211166966573997ull },
+    { 874922781278525018ull, 1807368933573259198ull },
+    { 8078635854506640661ull, 1445895146858607358ull },
+    { 13841606313089133175ull, 1156716117486885886ull },
+    { 14767872471458792434ull, 1850745787979017418ull },
+    { 746251532941302978ull, 1480596630383213935ull },
+    { 597001226353042382ull, 1184477304306571148ull },
+    { 15712597221132509104ull, 1895163686890513836ull },
+    { 8880728962164096960ull, 1516130949512411069ull },
+    { 10793931984473187891ull, 1212904759609928855ull },
+    { 17270291175157100626ull, 1940647615375886168ull },
+    { 2748186495899949531ull, 1552518092300708935ull },
+    { 2198549196719959625ull, 1242014473840567148ull },
+    { 18275073973719576693ull, 1987223158144907436ull },
+    { 10930710364233751031ull, 1589778526515925949ull },
+    { 12433917106128911148ull, 1271822821212740759ull },
+    { 8826220925580526867ull, 2034916513940385215ull },
+    { 7060976740464421494ull, 1627933211152308172ull },
+    { 16716827836597268165ull, 1302346568921846537ull },
+    { 11989529279587987770ull, 2083754510274954460ull },
+    { 9591623423670390216ull, 1667003608219963568ull },
+    { 15051996368420132820ull, 1333602886575970854ull },
+    { 13015147745246481542ull, 2133764618521553367ull },
+    { 3033420566713364587ull, 1707011694817242694ull },
+    { 6116085268112601993ull, 1365609355853794155ull },
+    { 9785736428980163188ull, 2184974969366070648ull },
+    { 15207286772667951197ull, 1747979975492856518ull },
+    { 1097782973908629988ull, 1398383980394285215ull },
+    { 1756452758253807981ull, 2237414368630856344ull },
+    { 5094511021344956708ull, 1789931494904685075ull },
+    { 4075608817075965366ull, 1431945195923748060ull },
+    { 6520974107321544586ull, 2291112313477996896ull },
+    { 1527430471115325346ull, 1832889850782397517ull },
+    { 12289990821117991246ull, 1466311880625918013ull },
+    { 17210690286378213644ull, 1173049504500734410ull },
+    { 9090360384495590213ull, 1876879207201175057ull },
+    { 18340334751822203140ull, 1501503365760940045ull },
+    { 14672267801457762512ull, 1201202692608752036ull },
+    { 16096930852848599373ull, 1921924308174003258ull },
+    { 1809498238053148529ull, 1537539446539202607ull },
+    { 12515645034668249793ull, 1230031557231362085ull },
+    { 1578287981759648052ull, 1968050491570179337ull },
+    { 12330676829633449412ull, 1574440393256143469ull },
+    { 13553890278448669853ull, 1259552314604914775ull },
+    { 3239480371808320148ull, 2015283703367863641ull },
+    { 17348979556414297411ull, 1612226962694290912ull },
+    { 6500486015647617283ull, 1289781570155432730ull },
+    { 10400777625036187652ull, 2063650512248692368ull },
+    { 15699319729512770768ull, 1650920409798953894ull },
+    { 16248804598352126938ull, 1320736327839163115ull },
+    { 7551343283653851484ull, 2113178124542660985ull },
+    { 6041074626923081187ull, 1690542499634128788ull },
+    { 12211557331022285596ull, 1352433999707303030ull },
+    { 1091747655926105338ull, 2163894399531684849ull },
+    { 4562746939482794594ull, 1731115519625347879ull },
+    { 7339546366328145998ull, 1384892415700278303ull },
+    { 8053925371383123274ull, 2215827865120445285ull },
+    { 6443140297106498619ull, 1772662292096356228ull },
+    { 12533209867169019542ull, 1418129833677084982ull },
+    { 5295740528502789974ull, 2269007733883335972ull },
+    { 15304638867027962949ull, 1815206187106668777ull },
+    { 4865013464138549713ull, 1452164949685335022ull },
+    { 14960057215536570740ull, 1161731959748268017ull },
+    { 9178696285890871890ull, 1858771135597228828ull },
+    { 14721654658196518159ull, 1487016908477783062ull },
+    { 4398626097073393881ull, 1189613526782226450ull },
+    { 7037801755317430209ull, 1903381642851562320ull },
+    { 5630241404253944167ull, 1522705314281249856ull },
+    { 814844308661245011ull, 1218164251424999885ull },
+    { 1303750893857992017ull, 1949062802279999816ull },
+    { 15800395974054034906ull, 1559250241823999852ull },
+    { 5261619149759407279ull, 1247400193459199882ull },
+    { 12107939454356961969ull, 1995840309534719811ull },
+    { 5997002748743659252ull, 1596672247627775849ull },
+    { 8486951013736837725ull, 1277337798102220679ull },
+    { 2511075177753209390ull, 2043740476963553087ull },
+    { 13076906586428298482ull, 1634992381570842469ull },
+    { 14150874083884549109ull, 1307993905256673975ull },
+    { 4194654460505726958ull, 2092790248410678361ull },
+    { 18113118827372222859ull, 1674232198728542688ull },
+    { 3422448617672047318ull, 1339385758982834151ull },
+    { 16543964232501006678ull, 2143017214372534641ull },
+    { 9545822571258895019ull, 1714413771498027713ull },
+    { 15015355686490936662ull, 1371531017198422170ull },
+    { 5577825024675947042ull, 2194449627517475473ull },
+    { 11840957649224578280ull, 1755559702013980378ull },
+    { 16851463748863483271ull, 1404447761611184302ull },
+    { 12204946739213931940ull, 2247116418577894884ull },
+    { 13453306206113055875ull, 1797693134862315907ull },
+    { 3383947335406624054ull, 1438154507889852726ull },
+    { 16482362180876329456ull, 2301047212623764361ull },
+    { 9496540929959153242ull, 1840837770099011489ull },
+    { 11286581558709232917ull, 1472670216079209191ull },
+    { 5339916432225476010ull, 1178136172863367353ull },
+    { 4854517476818851293ull, 1885017876581387765ull },
+    { 3883613981455081034ull, 1508014301265110212ull },
+    { 14174937629389795797ull, 1206411441012088169ull },
+    { 11611853762797942306ull, 1930258305619341071ull },
+    { 5600134195496443521ull, 1544206644495472857ull },
+    { 15548153800622885787ull, 1235365315596378285ull },
+    { 6430302007287065643ull, 1976584504954205257ull },
+    { 16212288050055383484ull, 1581267603963364205ull },
+    { 12969830440044306787ull, 1265014083170691364ull },
+    { 9683682259845159889ull, 2024022533073106183ull },
+    { 15125643437359948558ull, 1619218026458484946ull },
+    { 8411165935146048523ull, 1295374421166787957ull },
+    { 17147214310975587960ull, 2072599073866860731ull },
+    { 10028422634038560045ull, 1658079259093488585ull },
+    { 8022738107230848036ull, 1326463407274790868ull },
+    { 9147032156827446534ull, 2122341451639665389ull },
+    { 11006974540203867551ull, 1697873161311732311ull },
+    { 5116230817421183718ull, 1358298529049385849ull },
+    { 15564666937357714594ull, 2173277646479017358ull },
+    { 1383687105660440706ull, 1738622117183213887ull },
+    { 12174996128754083534ull, 1390897693746571109ull },
+    { 8411947361780802685ull, 2225436309994513775ull },
+    { 6729557889424642148ull, 1780349047995611020ull },
+    { 5383646311539713719ull, 1424279238396488816ull },
+    { 1235136468979721303ull, 2278846781434382106ull },
+    { 15745504434151418335ull, 1823077425147505684ull },
+    { 16285752362063044992ull, 1458461940118004547ull },
+    { 5649904260166615347ull, 1166769552094403638ull },
+    { 5350498001524674232ull, 1866831283351045821ull },
+    { 591049586477829062ull, 1493465026680836657ull },
+    { 11540886113407994219ull, 1194772021344669325ull },
+    { 18673707743239135ull, 1911635234151470921ull },
+    { 14772334225162232601ull, 1529308187321176736ull },
+    { 8128518565387875758ull, 1223446549856941389ull },
+    { 1937583260394870242ull, 1957514479771106223ull },
+    { 8928764237799716840ull, 1566011583816884978ull },
+    { 14521709019723594119ull, 1252809267053507982ull },
+    { 8477339172590109297ull, 2004494827285612772ull },
+    { 17849917782297818407ull, 1603595861828490217ull },
+    { 6901236596354434079ull, 1282876689462792174ull },
+    { 18420676183650915173ull, 2052602703140467478ull },
+    { 3668494502695001169ull, 1642082162512373983ull },
+    { 10313493231639821582ull, 1313665730009899186ull },
+    { 9122891541139893884ull, 2101865168015838698ull },
+    { 14677010862395735754ull, 1681492134412670958ull },
+    { 673562245690857633ull, 1345193707530136767ull },
+};
+
+local const u64 ryu_pow5_split[RYU_POW5_TABLE_SIZE][2] = {
+    { 0ull, 1152921504606846976ull },
+    { 0ull, 1441151880758558720ull },
+    { 0ull, 1801439850948198400ull },
+    { 0ull, 2251799813685248000ull },
+    { 0ull, 1407374883553280000ull },
+    { 0ull, 1759218604441600000ull },
+    { 0ull, 2199023255552000000ull },
+    { 0ull, 1374389534720000000ull },
+    { 0ull, 1717986918400000000ull },
+    { 0ull, 2147483648000000000ull },
+    { 0ull, 1342177280000000000ull },
+    { 0ull, 1677721600000000000ull },
+    { 0ull, 2097152000000000000ull },
+    { 0ull, 1310720000000000000ull },
+    { 0ull, 1638400000000000000ull },
+    { 0ull, 2048000000000000000ull },
+    { 0ull, 1280000000000000000ull },
+    { 0ull, 1600000000000000000ull },
+    { 0ull, 2000000000000000000ull },
+    { 0ull, 1250000000000000000ull },
+    { 0ull, 1562500000000000000ull },
+    { 0ull, 1953125000000000000ull },
+    { 0ull, 1220703125000000000ull },
+    { 0ull, 1525878906250000000ull },
+    { 0ull, 1907348632812500000ull },
+    { 0ull, 1192092895507812500ull },
+    { 0ull, 1490116119384765625ull },
+    { 4611686018427387904ull, 1862645149230957031ull },
+    { 9799832789158199296ull, 1164153218269348144ull },
+    { 12249790986447749120ull, 1455191522836685180ull },
+    { 15312238733059686400ull, 1818989403545856475ull },
+    { 14528612397897220096ull, 2273736754432320594ull },
+    { 13692068767113150464ull, 1421085471520200371ull },
+    { 12503399940464050176ull, 1776356839400250464ull },
+    { 15629249925580062720ull, 2220446049250313080ull },
+    { 9768281203487539200ull, 1387778780781445675ull },
+    { 7598665485932036096ull, 1734723475976807094ull },
+    { 274959820560269312ull, 2168404344971008868ull },
+    { 9395221924704944128ull, 1355252715606880542ull },
+    { 2520655369026404352ull, 1694065894508600678ull },
+    { 12374191248137781248ull, 2117582368135750847ull },
+    { 14651398557727195136ull, 1323488980084844279ull },
+    { 13702562178731606016ull, 1654361225106055349ull },
+    { 3293144668132343808ull, 2067951531382569187ull },
+    { 18199116482078572544ull, 1292469707114105741ull },
+    { 8913837547316051968ull, 1615587133892632177ull },
+    { 15753982952572452864ull, 2019483917365790221ull },
+    { 12152082354571476992ull, 1262177448353618888ull },
+    { 15190102943214346240ull, 1577721810442023610ull },
+    { 9764256642163156992ull, 1972152263052529513ull },
+    { 17631875447420442880ull, 1232595164407830945ull },
+    { 8204786253993389888ull, 1540743955509788682ull },
+    { 1032610780636961552ull, 1925929944387235853ull },
+    { 2951224747111794922ull, 1203706215242022408ull },
+    { 3689030933889743652ull, 1504632769052528010ull },
+    { 13834660704216955373ull, 1880790961315660012ull },
+    { 17870034976990372916ull, 1175494350822287507ull },
+    { 17725857702810578241ull, 1469367938527859384ull },
+    { 3710578054803671186ull, 1836709923159824231ull },
+    { 26536550077201078ull, 2295887403949780289ull },
+    { 11545800389866720434ull, 1434929627468612680ull },
+    { 14432250487333400542ull, 1793662034335765850ull },
+    { 8816941072311974870ull, 2242077542919707313ull },
+    { 17039803216263454053ull, 1401298464324817070ull },
+    { 12076381983474541759ull, 1751623080406021338ull },
+    { 5872105442488401391ull, 2189528850507526673ull },
+    { 15199280947623720629ull, 1368455531567204170ull },
+    { 9775729147674874978ull, 1710569414459005213ull },
+    { 16831347453020981627ull, 2138211768073756516ull },
+    { 1296220121283337709ull, 1336382355046097823ull },
+    { 15455333206886335848ull, 1670477943807622278ull },
+    { 10095794471753144002ull, 2088097429759527848ull },
+    { 6309871544845715001ull, 1305060893599704905ull },
+    { 12499025449484531656ull, 1631326116999631131ull },
+    { 11012095793428276666ull, 2039157646249538914ull },
+    { 11494245889320060820ull, 1274473528905961821ull },
+    { 532749306367912313ull, 1593091911132452277ull },
+    { 5277622651387278295ull, 1991364888915565346ull },
+    { 7910200175544436838ull, 1244603055572228341ull },
+    { 14499436237857933952ull, 1555753819465285426ull },
+    { 8900923260467641632ull, 1944692274331606783ull },
+    { 12480606065433357876ull, 1215432671457254239ull },
+    { 10989071563364309441ull, 1519290839321567799ull },
+    { 9124653435777998898ull, 1899113549151959749ull },
+    { 8008751406574943263ull, 1186945968219974843ull },
+    { 5399253239791291175ull, 1483682460274968554ull },
+    { 15972438586593889776ull, 1854603075343710692ull },
+    { 759402079766405302ull, 1159126922089819183ull },
+    { 14784310654990170340ull, 1448908652612273978ull },
+    { 9257016281882937117ull, 1811135815765342473ull },
+    { 16182956370781059300ull, 2263919769706678091ull },
+    { 7808504722524468110ull, 1414949856066673807ull },
+    { 5148944884728197234ull, 1768687320083342259ull },
+    { 1824495087482858639ull, 2210859150104177824ull },
+    { 1140309429676786649ull, 1381786968815111140ull },
+    { 1425386787095983311ull, 1727233711018888925ull },
+    { 6393419502297367043ull, 2159042138773611156ull },
+    { 13219259225790630210ull, 1349401336733506972ull },
+    { 16524074032238287762ull, 1686751670916883715ull },
+    { 16043406521870471799ull, 2108439588646104644ull },
+    { 803757039314269066ull, 1317774742903815403ull },
+    { 14839754354425000045ull, 1647218428629769253ull },
+    { 4714634887749086344ull, 2059023035787211567ull },
+    { 9864175832484260821ull, 1286889397367007229ull },
+    { 16941905809032713930ull, 1608611746708759036ull },
+    { 2730638187581340797ull, 2010764683385948796ull },
+    { 10930020904093113806ull, 1256727927116217997ull },
+    { 18274212148543780162ull, 1570909908895272496ull },
+    { 4396021111970173586ull, 1963637386119090621ull },
+    { 5053356204195052443ull, 1227273366324431638ull },
+    { 15540067292098591362ull, 1534091707905539547ull },
+    { 14813398096695851299ull, 1917614634881924434ull },
+    { 13870059828862294966ull, 1198509146801202771ull },
+    { 12725888767650480803ull, 1498136433501503464ull },
+    { 15907360959563101004ull, 1872670541876879330ull },
+    { 14553786618154326031ull, 1170419088673049581ull },
+    { 4357175217410743827ull, 1463023860841311977ull },
+    { 10058155040190817688ull, 1828779826051639971ull },
+    { 7961007781811134206ull, 2285974782564549964ull },
+    { 14199001900486734687ull, 1428734239102843727ull },
+    { 13137066357181030455ull, 1785917798878554659ull },
+    { 11809646928048900164ull, 2232397248598193324ull },
+    { 16604401366885338411ull, 1395248280373870827ull },
+    { 16143815690179285109ull, 1744060350467338534ull },
+    { 10956397575869330579ull, 2180075438084173168ull },
+    { 6847748484918331612ull, 1362547148802608230ull },
+    { 17783057643002690323ull, 1703183936003260287ull },
+    { 17617136035325974999ull, 2128979920004075359ull },
+    { 17928239049719816230ull, 1330612450002547099ull },
+    { 17798612793722382384ull, 1663265562503183874ull },
+    { 13024893955298202172ull, 2079081953128979843ull },
+    { 5834715712847682405ull, 1299426220705612402ull },
+    { 16516766677914378815ull, 1624282775882015502ull },
+    { 11422586310538197711ull, 2030353469852519378ull },
+    { 11750802462513761473ull, 1268970918657824611ull },
+    { 10076817059714813937ull, 1586213648322280764ull },
+    { 12596021324643517422ull, 1982767060402850955ull },
+    { 5566670318688504437ull, 1239229412751781847ull },
+    { 2346651879933242642ull, 1549036765939727309ull },
+    { 7545000868343941206ull, 1936295957424659136ull },
+    { 4715625542714963254ull, 1210184973390411960ull },
+    { 5894531928393704067ull, 1512731216738014950ull },
+    { 16591536947346905892ull, 1890914020922518687ull },
+    { 17287239619732898039ull, 1181821263076574179ull },
+    { 16997363506238734644ull, 1477276578845717724ull },
+    { 2799960309088866689ull, 1846595723557147156ull },
+    { 10973347230035317489ull, 1154122327223216972ull },
+    { 13716684037544146861ull, 1442652909029021215ull },
+    { 12534169028502795672ull, 1803316136286276519ull },
+    { 11056025267201106687ull, 2254145170357845649ull },
+    { 18439230838069161439ull, 1408840731473653530ull },
+    { 13825666510731675991ull, 1761050914342066913ull },
+    { 3447025083132431277ull, 2201313642927583642ull },
+    { 6766076695385157452ull, 1375821026829739776ull },
+    { 8457595869231446815ull, 1719776283537174720ull },
+    { 10571994836539308519ull, 2149720354421468400ull },
+    { 6607496772837067824ull, 1343575221513417750ull },
+    { 17482743002901110588ull, 1679469026891772187ull },
+    { 17241742735199000331ull, 2099336283614715234ull },
+    { 15387775227926763111ull, 1312085177259197021ull },
+    { 5399660979626290177ull, 1640106471573996277ull },
+    { 11361262242960250625ull, 2050133089467495346ull },
+    { 11712474920277544544ull, 1281333180917184591ull },
+    { 10028907631919542777ull, 1601666476146480739ull },
+    { 7924448521472040567ull, 2002083095183100924ull },
+    { 14176152362774801162ull, 1251301934489438077ull },
+    { 3885132398186337741ull, 1564127418111797597ull },
+    { 9468101516160310080ull, 1955159272639746996ull },
+    { 15140935484454969608ull, 1221974545399841872ull },
+    { 479425281859160394ull, 1527468181749802341ull },
+    { 5210967620751338397ull, 1909335227187252926ull },
+    { 17091912818251750210ull, 1193334516992033078ull },
+    { 12141518985959911954ull, 1491668146240041348ull },
+    { 15176898732449889943ull, 1864585182800051685ull },
+    { 11791404716994875166ull, 1165365739250032303ull },
+    { 10127569877816206054ull, 1456707174062540379ull },
+    { 8047776328842869663ull, 1820883967578175474ull },
+    { 836348374198811271ull, 2276104959472719343ull },
+    { 7440246761515338900ull, 1422565599670449589ull },
+    { 13911994470321561530ull, 1778206999588061986ull },
+    { 8166621051047176104ull, 2222758749485077483ull },
+    { 2798295147690791113ull, 1389224218428173427ull },
+    { 17332926989895652603ull, 1736530273035216783ull },
+    { 17054472718942177850ull, 2170662841294020979ull },
+    { 8353202440125167204ull, 1356664275808763112ull },
+    { 10441503050156459005ull, 1695830344760953890ull },
+    { 3828506775840797949ull, 2119787930951192363ull },
+    { 86973725686804766ull, 1324867456844495227ull },
+    { 13943775212390669669ull, 1656084321055619033ull },
+    { 3594660960206173375ull, 2070105401319523792ull },
+    { 2246663100128858359ull, 1293815875824702370ull },
+    { 12031700912015848757ull, 1617269844780877962ull },
+    { 5816254103165035138ull, 2021587305976097453ull },
+    { 5941001823691840913ull, 1263492066235060908ull },
+    { 7426252279614801142ull, 1579365082793826135ull },
+    { 4671129331091113523ull, 1974206353492282669ull },
+    { 5225298841145639904ull, 1233878970932676668ull },
+    { 6531623551432049880ull, 1542348713665845835ull },
+    { 3552843420862674446ull, 1927935892082307294ull },
+    { 16055585193321335241ull, 1204959932551442058ull },
+    { 10846109454796893243ull, 1506199915689302573ull },
+    { 18169322836923504458ull, 1882749894611628216ull },
+    { 11355826773077190286ull, 1176718684132267635ull },
+    { 9583097447919099954ull, 1470898355165334544ull },
+    { 11978871809898874942ull, 1838622943956668180ull },
+    { 14973589762373593678ull, 2298278679945835225ull },
+    { 2440964573842414192ull, 1436424174966147016ull },
+    { 3051205717303017741ull, 1795530218707683770ull },
+    { 13037379183483547984ull, 2244412773384604712ull },
+    { 8148361989677217490ull, 1402757983365377945ull },
+    { 14797138505523909766ull, 1753447479206722431ull },
+    { 13884737113477499304ull, 2191809349008403039ull },
+    { 15595489723564518921ull, 1369880843130251899ull },
+    { 14882676136028260747ull, 1712351053912814874ull },
+    { 9379973133180550126ull, 2140438817391018593ull },
+    { 17391698254306313589ull, 1337774260869386620ull },
+    { 3292878744173340370ull, 1672217826086733276ull },
+    { 4116098430216675462ull, 2090272282608416595ull },
+    { 266718509671728212ull, 1306420176630260372ull },
+    { 333398137089660265ull, 1633025220787825465ull },
+    { 5028433689789463235ull, 2041281525984781831ull },
+    { 10060300083759496378ull, 1275800953740488644ull },
+    { 12575375104699370472ull, 1594751192175610805ull },
+    { 1884160825592049379ull, 1993438990219513507ull },
+    { 17318501580490888525ull, 1245899368887195941ull },
+    { 7813068920331446945ull, 1557374211108994927ull },
+    { 5154650131986920777ull, 1946717763886243659ull },
+    { 915813323278131534ull, 1216698602428902287ull },
+    { 14979824709379828129ull, 1520873253036127858ull },
+    { 9501408849870009354ull, 1901091566295159823ull },
+    { 12855909558809837702ull, 1188182228934474889ull },
+    { 2234828893230133415ull, 1485227786168093612ull },
+    { 2793536116537666769ull, 1856534732710117015ull },
+    { 8663489100477123587ull, 1160334207943823134ull },
+    { 1605989338741628675ull, 1450417759929778918ull },
+    { 11230858710281811652ull, 1813022199912223647ull },
+    { 9426887369424876662ull, 2266277749890279559ull },
+    { 12809333633531629769ull, 1416423593681424724ull },
+    { 16011667041914537212ull, 1770529492101780905ull },
+    { 6179525747111007803ull, 2213161865127226132ull },
+    { 13085575628799155685ull, 1383226165704516332ull },
+    { 16356969535998944606ull, 1729032707130645415ull },
+    { 15834525901571292854ull, 2161290883913306769ull },
+    { 2979049660840976177ull, 1350806802445816731ull },
+    { 17558870131333383934ull, 1688508503057270913ull },
+    { 8113529608884566205ull, 2110635628821588642ull },
+    { 9682642023980241782ull, 1319147268013492901ull },
+    { 16714988548402690132ull, 1648934085016866126ull },
+    { 11670363648648586857ull, 2061167606271082658ull },
+    { 11905663298832754689ull, 1288229753919426661ull },
+    { 1047021068258779650ull, 1610287192399283327ull },
+    { 15143834390605638274ull, 2012858990499104158ull },
+    { 4853210475701136017ull, 1258036869061940099ull },
+    { 1454827076199032118ull, 1572546086327425124ull },
+    { 1818533845248790147ull, 1965682607909281405ull },
+    { 3442426662494187794ull, 1228551629943300878ull },
+    { 13526405364972510550ull, 1535689537429126097ull },
+    { 3072948650933474476ull, 1919611921786407622ull },
+    { 15755650962115585259ull, 1199757451116504763ull },
+    { 15082877684217093670ull, 1499696813895630954ull },
+    { 9630225068416591280ull, 1874621017369538693ull },
+    { 8324733676974063502ull, 1171638135855961683ull },
+    { 5794231077790191473ull, 1464547669819952104ull },
+    { 7242788847237739342ull, 1830684587274940130ull },
+    { 18276858095901949986ull, 2288355734093675162ull },
+    { 16034722328366106645ull, 1430222333808546976ull },
+    { 1596658836748081690ull, 1787777917260683721ull },
+    { 6607509564362490017ull, 2234722396575854651ull },
+    { 1823850468512862308ull, 1396701497859909157ull },
+    { 6891499104068465790ull, 1745876872324886446ull },
+    { 17837745916940358045ull, 2182346090406108057ull },
+    { 4231062170446641922ull, 1363966306503817536ull },
+    { 5288827713058302403ull, 1704957883129771920ull },
+    { 6611034641322878003ull, 2131197353912214900ull },
+    { 13355268687681574560ull, 1331998346195134312ull },
+    { 16694085859601968200ull, 1664997932743917890ull },
+    { 11644235287647684442ull, 2081247415929897363ull },
+    { 4971804045566108824ull, 1300779634956185852ull },
+    { 6214755056957636030ull, 1625974543695232315ull },
+    { 3156757802769657134ull, 2032468179619040394ull },
+    { 6584659645158423613ull, 1270292612261900246ull },
+    { 17454196593302805324ull, 1587865765327375307ull },
+    { 17206059723201118751ull, 1984832206659219134ull },
+    { 6142101308573311315ull, 1240520129162011959ull },
+    { 3065940617289251240ull, 1550650161452514949ull },
+    { 8444111790038951954ull, 1938312701815643686ull },
+    { 665883850346957067ull, 1211445438634777304ull },
+    { 832354812933696334ull, 1514306798293471630ull },
+    { 10263815553021896226ull, 1892883497866839537ull },
+    { 17944099766707154901ull, 1183052186166774710ull },
+    { 13206752671529167818ull, 1478815232708468388ull },
+    { 16508440839411459773ull, 1848519040885585485ull },
+    { 12623618533845856310ull, 1155324400553490928ull },
+    { 15779523167307320387ull, 1444155500691863660ull },
+    { 1277659885424598868ull, 1805194375864829576ull },
+    { 1597074856780748586ull, 2256492969831036970ull },
+    { 5609857803915355770ull, 1410308106144398106ull },
+    { 16235694291748970521ull, 1762885132680497632ull },
+    { 1847873790976661535ull, 2203606415850622041ull },
+    { 12684136165428883219ull, 1377254009906638775ull },
+    { 11243484188358716120ull, 1721567512383298469ull },
+    { 219297180166231438ull, 2151959390479123087ull },
+    { 7054589765244976505ull, 1344974619049451929ull },
+    { 13429923224983608535ull, 1681218273811814911ull },
+    { 12175718012802122765ull, 2101522842264768639ull },
+    { 14527352785642408584ull, 1313451776415480399ull },
+    { 13547504963625622826ull, 1641814720519350499ull },
+    { 12322695186104640628ull, 2052268400649188124ull },
+    { 16925056528170176201ull, 1282667750405742577ull },
+    { 7321262604930556539ull, 1603334688007178222ull },
+    { 18374950293017971482ull, 2004168360008972777ull },
+    { 4566814905495150320ull, 1252605225005607986ull },
+    { 14931890668723713708ull, 1565756531257009982ull },
+    { 9441491299049866327ull, 1957195664071262478ull },
+    { 1289246043478778550ull, 1223247290044539049ull },
+    { 6223243572775861092ull, 1529059112555673811ull },
+    { 3167368447542438461ull, 1911323890694592264ull },
+    { 1979605279714024038ull, 1194577431684120165ull },
+    { 7086192618069917952ull, 1493221789605150206ull },
+    { 18081112809442173248ull, 1866527237006437757ull },
+    { 13606538515115052232ull, 1166579523129023598ull },
+    { 7784801107039039482ull, 1458224403911279498ull },
+    { 507629346944023544ull, 1822780504889099373ull },
+    { 5246222702107417334ull, 2278475631111374216ull },
+    { 3278889188817135834ull, 1424047269444608885ull },
+    { 8710297504448807696ull, 1780059086805761106ull },
+};
+
+// ceil(log2(5^e)) for e > 0, 1 for e == 0.
+local s32 ryu_pow5_bits(s32 e) {
+    return (s32)(((u32)e * 1217359) >> 19) + 1;
+}
+
+// floor(log10(2^e)).
+local u32 ryu_log10_pow2(s32 e) {
+    return ((u32)e * 78913) >> 18;
+}
+
+// floor(log10(5^e)).
+local u32 ryu_log10_pow5(s32 e) {
+    return ((u32)e * 732923) >> 20;
+}
+
+local b8 ryu_multiple_of_pow5(u64 val, u32 p) {
+    u32 count = 0;
+    while (val % 5 == 0 && count < p) {
+        val   /= 5;
+        count += 1;
+    }
+    return count >= p;
+}
+
+local b8 ryu_multiple_of_pow2(u64 val, u32 p) {
+    return (val & (((u64)1 << p) - 1)) == 0;
+}
+
+// (m * mul) >> j with a 128-bit multiplier, `m` is at most 55 bits and j >= 64.
+local u64 ryu_mul_shift(u64 m, const u64* mul, s32 j) {
+    u64 high0;
+    umul128(m, mul[0], &high0);
+    u64 high1;
+    u64 low1 = umul128(m, mul[1], &high1);
+    u64 sum  = high0 + low1;
+    if (sum < high0) high1 += 1;
+    return shift_right128(sum, high1, j - 64);
+}
+
+typedef struct {
+    u64 digits;
+    s32 exponent; // The value is `digits * 10^exponent`.
+} DecimalFloat;
+
+// Shortest decimal in the rounding interval of `m2 * 2^e2`. `lower_closer` is
+// set when the value sits on a power of two, making the interval asymmetric.
+local DecimalFloat ryu_shortest(u64 m2, s32 e2, b8 lower_closer) {
+    e2 -= 2;
+    b8  accept_bounds = (m2 & 1) == 0;
+    u64 mv            = 4 * m2;
+    u32 mm_shift      = !lower_closer;
+
+    u64 vr, vp, vm;
+    s32 e10;
+    b8  vm_trailing_zeros = false;
+    b8  vr_trailing_zeros = false;
+    if (e2 >= 0) {
+        u32 q = ryu_log10_pow2(e2) - (e2 > 3);
+        e10   = (s32)q;
+        s32 k = RYU_POW5_INV_BITCOUNT + ryu_pow5_bits((s32)q) - 1;
+        s32 i = -e2 + (s32)q + k;
+        vr    = ryu_mul_shift(4 * m2, ryu_pow5_inv_split[q], i);
+        vp    = ryu_mul_shift(4 * m2 + 2, ryu_pow5_inv_split[q], i);
+        vm    = ryu_mul_shift(4 * m2 - 1 - mm_shift, ryu_pow5_inv_split[q], i);
+        if (q <= 21) {
+            // Only one of mp, mv and mm can be a multiple of 5, if any.
+            if (mv % 5 == 0) {
+                vr_trailing_zeros = ryu_multiple_of_pow5(mv, q);
+            } else if (accept_bounds) {
+                vm_trailing_zeros = ryu_multiple_of_pow5(mv - 1 - mm_shift, q);
+            } else {
+                vp -= ryu_multiple_of_pow5(mv + 2, q);
+            }
+        }
+    } else {
+        u32 q = ryu_log10_pow5(-e2) - (-e2 > 1);
+        e10   = (s32)q + e2;
+        s32 i = -e2 - (s32)q;
+        s32 k = ryu_pow5_bits(i) - RYU_POW5_BITCOUNT;
+        s32 j = (s32)q - k;
+        vr    = ryu_mul_shift(4 * m2, ryu_pow5_split[i], j);
+        vp    = ryu_mul_shift(4 * m2 + 2, ryu_pow5_split[i], j);
+        vm    = ryu_mul_shift(4 * m2 - 1 - mm_shift, ryu_pow5_split[i], j);
+        if (q <= 1) {
+            // mv has at least q trailing zero bits, so vr is exact.
+            vr_trailing_zeros = true;
+            if (accept_bounds) {
+                vm_trailing_zeros = mm_shift == 1;
+            } else {
+                vp -= 1;
+            }
+        } else if (q < 63) {
+            vr_trailing_zeros = ryu_multiple_of_pow2(mv, q);
+        }
+    }
+
+    s32 removed        = 0;
+    u8  last_removed   = 0;
+    u64 output;
+    if (vm_trailing_zeros || vr_trailing_zeros) {
+        // Rare path, the exact ties need the removed digits.
+        while (vp / 10 > vm / 10) {
+            vm_trailing_zeros &= vm % 10 == 0;
+            vr_trailing_zeros &= last_removed == 0;
+            last_removed       = vr % 10;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed += 1;
+        }
+        if (vm_trailing_zeros) {
+            while (vm % 10 == 0) {
+                vr_trailing_zeros &= last_removed == 0;
+                last_removed       = vr % 10;
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed += 1;
+            }
+        }
+        // Round half to even on an exact tie.
+        if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0) last_removed = 4;
+        output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed >= 5);
+    } else {
+        b8 round_up = false;
+        if (vp / 100 > vm / 100) {
+            round_up  = vr % 100 >= 50;
+            vr       /= 100;
+            vp       /= 100;
+            vm       /= 100;
+            removed  += 2;
+        }
+        while (vp / 10 > vm / 10) {
+            round_up  = vr % 10 >= 5;
+            vr       /= 10;
+            vp       /= 10;
+            vm       /= 10;
+            removed  += 1;
+        }
+        output = vr + (vr == vm || round_up);
+    }
+
+    return (DecimalFloat) {
+        .digits   = output,
+        .exponent = e10 + removed,
+    };
+}
+
+// Writes `digits * 10^exponent` like Python's repr: positional for decimal
+// exponents in [-4, 16), scientific otherwise, always with a fraction or an
+// exponent so it reads back as a float.
+local void string_write_decimal(String* str, DecimalFloat dec) {
+    u8  digits[20];
+    u32 length = write_digits(digits, dec.digits);
+    s32 sci    = dec.exponent + (s32)length - 1;
+    u8* out    = str->buffer + str->length;
+
+    if (sci < -4 || sci >= 16) {
+        *out++ = digits[0];
+        if (length > 1) {
+            *out++ = '.';
+            memcpy(out, digits + 1, length - 1);
+            out += length - 1;
+        }
+        *out++ = 'e';
+        *out++ = sci < 0 ? '-' : '+';
+        u32 exp = sci < 0 ? -sci : sci;
+        if (exp < 10) *out++ = '0';
+        out += write_digits(out, exp);
+    } else if (dec.exponent >= 0) {
+        memcpy(out, digits, length);
+        out += length;
+        memset(out, '0', dec.exponent);
+        out    += dec.exponent;
+        *out++  = '.';
+        *out++  = '0';
+    } else if (sci >= 0) {
+        memcpy(out, digits, sci + 1);
+        out    += sci + 1;
+        *out++  = '.';
+        memcpy(out, digits + sci + 1, length - sci - 1);
+        out += length - sci - 1;
+    } else {
+        *out++ = '0';
+        *out++ = '.';
+        memset(out, '0', -sci - 1);
+        out += -sci - 1;
+        memcpy(out, digits, length);
+        out += length;
+    }
+    str->length = out - str->buffer;
+}
+
+// Handles sign, zero, infinity and NaN, returns false if `m2 * 2^e2` still
+// needs to be written.
+local b8 string_write_special(String* str, b8 sign, b8 max_exponent, u64 mantissa, b8 zero) {
+    if (max_exponent && mantissa != 0) {
+        string_write_str(str, "nan");
+        return true;
+    }
+    if (sign) {
+        str->buffer[str->length] = '-';
+        str->length += 1;
+    }
+    if (max_exponent) {
+        string_write_str(str, "inf");
+        return true;
+    }
+    if (zero) {
+        string_write_str(str, "0.0");
+        return true;
+    }
+    return false;
+}
+
+void string_write_f32(String* str, f32 val) {
+    u32 bits;
+    memcpy(&bits, &val, sizeof(bits));
+    u32 mantissa = bits & ((1u << 23) - 1);
+    u32 exponent = (bits >> 23) & 0xff;
+    if (string_write_special(str, bits >> 31, exponent == 0xff, mantissa, exponent == 0 && mantissa == 0)) return;
+
+    u64 m2 = exponent == 0 ? mantissa : mantissa | (1u << 23);
+    s32 e2 = (exponent == 0 ? 1 : (s32)exponent) - 127 - 23;
+    string_write_decimal(str, ryu_shortest(m2, e2, mantissa == 0 && exponent > 1));
+}
+
+void string_write_f64(String* str, f64 val) {
+    u64 bits;
+    memcpy(&bits, &val, sizeof(bits));
+    u64 mantissa = bits & (((u64)1 << 52) - 1);
+    u32 exponent = (bits >> 52) & 0x7ff;
+    if (string_write_special(str, bits >> 63, exponent == 0x7ff, mantissa, exponent == 0 && mantissa == 0)) return;
+
+    u64 m2 = exponent == 0 ? mantissa : mantissa | ((u64)1 << 52);
+    s32 e2 = (exponent == 0 ? 1 : (s32)exponent) - 1023 - 52;
+    string_write_decimal(str, ryu_shortest(m2, e2, mantissa == 0 && exponent > 1));
+}
+
+// `(high:low) >> shift` rounded half to even, the result must fit in 64 bits.
+// `lead` is the digit sitting left of the result, it decides ties when the
+// result has no digits of its own.
+local u64 round_shift_right128(u64 low, u64 high, u32 shift, u64 lead) {
+    if (shift >= 128) return 0;
+    u64 quot, rem_low = low, rem_high = 0, half_low = 0, half_high = 0;
+    if (shift < 64) {
+        quot     = shift_right128(low, high, shift);
+        rem_low  = low & (((u64)1 << shift) - 1);
+        half_low = (u64)1 << (shift - 1);
+    } else if (shift == 64) {
+        quot     = high;
+        half_low = (u64)1 << 63;
+    } else {
+        quot      = high >> (shift - 64);
+        rem_high  = high & (((u64)1 << (shift - 64)) - 1);
+        half_high = (u64)1 << (shift - 65);
+    }
+    b8 above = rem_high != half_high ? rem_high > half_high : rem_low > half_low;
+    b8 tie   = rem_high == half_high && rem_low == half_low;
+    return quot + (above || (tie && ((quot + lead) & 1)));
+}
+
+void string_write_f32_prec(String* str, f32 val, u32 precision) {
+    string_write_f64_prec(str, val, precision);
+}
+
+void string_write_f64_prec(String* str, f64 val, u32 precision) {
+    u64 bits;
+    memcpy(&bits, &val, sizeof(bits));
+    u64 mantissa = bits & (((u64)1 << 52) - 1);
+    u32 exponent = (bits >> 52) & 0x7ff;
+    if (string_write_special(str, bits >> 63, exponent == 0x7ff, mantissa, false)) return;
+
+    precision = MIN(precision, 19);
+    u64 m2    = exponent == 0 ? mantissa : mantissa | ((u64)1 << 52);
+    s32 e2    = (exponent == 0 ? 1 : (s32)exponent) - 1023 - 52;
+    u64 whole = 0;
+    u64 frac  = 0;
+    if (e2 >= 0 && msb_index(m2 | 1) + e2 >= 64) {
+        // Integers past 2^64 get their shortest digits padded with zeros.
+        DecimalFloat dec = ryu_shortest(m2, e2, mantissa == 0 && exponent > 1);
+        str->length += write_digits(str->buffer + str->length, dec.digits);
+        memset(str->buffer + str->length, '0', dec.exponent);
+        str->length += dec.exponent;
+    } else {
+        if (e2 >= 0) {
+            whole = m2 << e2;
+        } else {
+            u32 shift     = -e2;
+            u64 frac_bits = shift < 64 ? m2 & (((u64)1 << shift) - 1) : m2;
+            u64 scale     = precision == 0 ? 1 : digit_powers[precision];
+            u64 high;
+            u64 low       = umul128(frac_bits, scale, &high);
+            whole         = shift < 64 ? m2 >> shift : 0;
+            frac          = round_shift_right128(low, high, shift, precision == 0 ? whole : 0);
+            if (frac == scale) {
+                whole += 1;
+                frac   = 0;
+            }
+        }
+        str->length += write_digits(str->buffer + str->length, whole);
+    }
+
+    if (precision == 0) return;
+    str->buffer[str->length] = '.';
+    str->length += 1;
+    u32 length = count_digits(frac);
+    memset(str->buffer + str->length, '0', precision - length);
+    str->length += precision - length;
+    str->length += write_digits(str->buffer + str->length, frac);
+}
+
+void string_write_ptr(String* str, const void* ptr) {
+    str->buffer[str->length]     = '0';
+    str->buffer[str->length + 1] = 'x';
+    str->length += 2;
+    string_write_hex(str, (u64)ptr);
+}
+
+void string_null(String* str) {
+    str->buffer[str->length] = 0;
+    str->length += 1;
+}
+
+void string_newline(String* str) {
+    str->buffer[str->length] = '\n';
+    str->length += 1;
+}
+
+void string_reset(String* str) {
+    str->length = 0;
+}
+
+char* string_to_cstr(String* str) {
+    str->buffer[str->length] = 0;
+    return (char*)str->buffer;
+}
+
+typedef struct {
+    const u8* data;
+    u64       length;
+} WriteChunk;
+
+// Writes every chunk in order with as few calls as possible, resuming after
+// partial writes and interrupts.
+local b8 os_write_chunks(FileHandle fd, WriteChunk* chunks, u32 count) {
+#if defined(__unix)
+    struct iovec iov[8];
+    ASSERT(count <= LEN(iov));
+    for (u32 i = 0; i < count; i++) {
+        iov[i].iov_base = (void*)chunks[i].data;
+        iov[i].iov_len  = chunks[i].length;
+    }
+
+    u32 first = 0;
+    for (;;) {
+        while (first < count && iov[first].iov_len == 0) first++;
+        if (first == count) break;
+        ssize_t written = writev(fd, iov + first, (int)(count - first));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        // No progress on a non-empty write would spin forever.
+        if (written == 0) return false;
+        while (first < count && (size_t)written >= iov[first].iov_len) {
+            written -= (ssize_t)iov[first].iov_len;
+            first++;
+        }
+        if (first < count) {
+            iov[first].iov_base  = (u8*)iov[first].iov_base + written;
+            iov[first].iov_len  -= (size_t)written;
+        }
+    }
+    return true;
+#else
+    for (u32 i = 0; i < count; i++) {
+        const u8* data   = chunks[i].data;
+        u64       length = chunks[i].length;
+        while (length > 0) {
+            DWORD written = 0;
+            DWORD request = (DWORD)MIN(length, MAX_U32);
+            if (!WriteFile(fd, data, request, &written, NULL) || written == 0) return false;
+            data   += written;
+            length -= written;
+        }
+    }
+    return true;
+#endif
+}
+
+void string_print(const String str) {
+#if defined(__unix)
+	write(1, str.buffer, str.length);
+#else
+	HANDLE handle = GetStdHandle(STD_OUTPUT_HANDLE);
+	WriteFile(handle, str.buffer, str.length, NULL, NULL);
+#endif
+}
+
+void string_println(const String str) {
+#if defined(__unix)
+    WriteChunk chunks[] = { { str.buffer, str.length }, { (const u8*)"\n", 1 } };
+    os_write_chunks(1, chunks, LEN(chunks));
+#else
+    HANDLE handle = GetStdHandle(STD_OUTPUT_HANDLE);
+    WriteFile(handle, str.buffer, str.length, NULL, NULL);
+    WriteFile(handle, "\n", 1, NULL, NULL);
+#endif
+}
+
+void string_eprint(const String str) {
+#if defined(__unix)
+	write(2, str.buffer, str.length);
+#else
+	HANDLE handle = GetStdHandle(STD_ERROR_HANDLE);
+	WriteFile(handle, str.buffer, str.length, NULL, NULL);
+#endif
+}
+
+void string_eprintln(const String str) {
+#if defined(__unix)
+    WriteChunk chunks[] = { { str.buffer, str.length }, { (const u8*)"\n", 1 } };
+    os_write_chunks(2, chunks, LEN(chunks));
+#else
+    HANDLE handle = GetStdHandle(STD_ERROR_HANDLE);
+    WriteFile(handle, str.buffer, str.length, NULL, NULL);
+    WriteFile(handle, "\n", 1, NULL, NULL);
+#endif
+}
+
+String string_concat(Arena* arena, const String str1, const String str2) {
+	u64 new_length = str1.length + str2.length;
+	u8* new_str = arena_realloc(arena, str1.buffer, str1.length, new_length, 1);
+	if (new_str == NULL) return (String) { 0 };
+	if (str2.length > 0) memcpy(new_str + str1.length, str2.buffer, str2.length);
+
+	return (String) {
+		.buffer = new_str,
+		.length = new_length,
+	};
+}
+
+String string_slice(const String str, const u64 init, const u64 end) {
+	return (String) {
+		.buffer = str.buffer + init,
+		.length = end - init,
+	};
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                               STRING KERNELS                              */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Byte loops under the string functions. x86-64 builds carry SSE2, AVX2 and
+// AVX-512BW versions and pick one with cpuid at startup, other targets go
+// eight bytes at a time.
+
+// Index of the first byte where `a` and `b` differ, `length` when none do.
+typedef u64  (*MismatchFn)(const u8* a, const u8* b, u64 length);
+// Copies `src` to `dst` flipping the case of bytes in [lo, lo + 26), `dst`
+// may equal `src`.
+typedef void (*CaseFn)(u8* dst, const u8* src, u64 length, u8 lo);
+// Bit i is set when p[i] == first and p[i + gap] == last, for i in [0, 64).
+typedef u64  (*PairMaskFn)(const u8* p, u8 first, u8 last, u64 gap);
+typedef b8   (*Utf8ValidateFn)(const u8* p, u64 length);
+// Bytes that start a codepoint, the codepoint count for valid input.
+typedef u64  (*Utf8CountFn)(const u8* p, u64 length);
+
+local u64 mismatch_scalar(const u8* a, const u8* b, u64 length) {
+    u64 i = 0;
+    for (; i + 8 <= length; i += 8) {
+        u64 diff = load_u64(a + i) ^ load_u64(b + i);
+        if (diff != 0) return i + lsb_index(diff) / 8;
+    }
+    for (; i < length; i++) {
+        if (a[i] != b[i]) return i;
+    }
+    return length;
+}
+
+local void case_scalar(u8* dst, const u8* src, u64 length, u8 lo) {
+    const u64 ones = 0x0101010101010101ull;
+    u64 i = 0;
+    for (; i + 8 <= length; i += 8) {
+        // Bit 7 of each byte tells whether its low seven bits reach `lo` and
+        // `lo + 26`, bytes with bit 7 already set are not ASCII and stay.
+        u64 v       = load_u64(src + i);
+        u64 low7    = v & (ones * 0x7F);
+        u64 from_lo = low7 + ones * (0x80 - lo);
+        u64 from_hi = low7 + ones * (0x80 - lo - 26);
+        u64 mask    = from_lo & ~from_hi & ~v & (ones * 0x80);
+        v ^= mask >> 2;
+        memcpy(dst + i, &v, sizeof(v));
+    }
+    for (; i < length; i++) {
+        dst[i] = (u8)(src[i] - lo) < 26 ? src[i] ^ 0x20 : src[i];
+    }
+}
+
+#if !defined(SAMLIB_X86)
+local u64 pair_mask_scalar(const u8* p, u8 first, u8 last, u64 gap) {
+    u64 mask = 0;
+    for (u32 i = 0; i < 64; i++) {
+        mask |= (u64)(p[i] == first && p[i + gap] == last) << i;
+    }
+    return mask;
+}
+#endif
+
+// Length of the well-formed sequence at `p` (1 to 4), 0 when it is invalid,
+// truncated, overlong, a surrogate or past U+10FFFF.
+local u32 utf8_decode(const u8* p, u64 length, u32* codepoint) {
+    u8 c = p[0];
+    if (c < 0x80) {
+        *codepoint = c;
+        return 1;
+    }
+
+    u32 n, cp, min;
+    if ((c & 0xE0) == 0xC0) {
+        n = 1, cp = c & 0x1F, min = 0x80;
+    } else if ((c & 0xF0) == 0xE0) {
+        n = 2, cp = c & 0x0F, min = 0x800;
+    } else if ((c & 0xF8) == 0xF0) {
+        n = 3, cp = c & 0x07, min = 0x10000;
+    } else {
+        return 0;
+    }
+    if (length <= n) return 0;
+    for (u32 i = 1; i <= n; i++) {
+        if ((p[i] & 0xC0) != 0x80) return 0;
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+    if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return 0;
+    *codepoint = cp;
+    return n + 1;
+}
+
+local b8 utf8_validate_scalar(const u8* p, u64 length) {
+    u64 i = 0;
+    while (i < length) {
+        if (i + 8 <= length && (load_u64(p + i) & 0x8080808080808080ull) == 0) {
+            i += 8;
+            continue;
+        }
+        u32 cp;
+        u32 n = utf8_decode(p + i, length - i, &cp);
+        if (n == 0) return false;
+        i += n;
+    }
+    return true;
+}
+
+local u64 utf8_count_scalar(const u8* p, u64 length) {
+    u64 count = 0;
+    u64 i     = 0;
+    for (; i + 8 <= length; i += 8) {
+        // Every byte but 10xxxxxx starts a codepoint: bit 7 clear or bit 6 set.
+        u64 v  = load_u64(p + i);
+        count += popcount_u64((~v >> 7 | v >> 6) & 0x0101010101010101ull);
+    }
+    for (; i < length; i++) {
+        count += (p[i] & 0xC0) != 0x80;
+    }
+    return count;
+}
+
+#if defined(SAMLIB_X86)
+SIMD_TARGET("sse2")
+local u64 mismatch_sse2(const u8* a, const u8* b, u64 length) {
+    u64 i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i x  = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i y  = _mm_loadu_si128((const __m128i*)(b + i));
+        u32     eq = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+        if (eq != 0xFFFF) return i + lsb_index(~eq & 0xFFFF);
+    }
+    return i + mismatch_scalar(a + i, b + i, length - i);
+}
+
+SIMD_TARGET("avx2")
+local u64 mismatch_avx2(const u8* a, const u8* b, u64 length) {
+    u64 i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i x  = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y  = _mm256_loadu_si256((const __m256i*)(b + i));
+        u32     eq = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+        if (eq != ALL32) return i + lsb_index(~(u64)eq);
+    }
+    return i + mismatch_sse2(a + i, b + i, length - i);
+}
+
+SIMD_TARGET("avx512f,avx512bw")
+local u64 mismatch_avx512(const u8* a, const u8* b, u64 length) {
+    for (u64 i = 0; i < length; i += 64) {
+        // Masked loads never touch the bytes past `length`.
+        __mmask64 live = length - i >= 64 ? ALL64 : (1ull << (length - i)) - 1;
+        __m512i   x    = _mm512_maskz_loadu_epi8(live, a + i);
+        __m512i   y    = _mm512_maskz_loadu_epi8(live, b + i);
+        __mmask64 ne   = _mm512_mask_cmpneq_epi8_mask(live, x, y);
+        if (ne != 0) return i + lsb_index(ne);
+    }
+    return length;
+}
+
+// Adding 0x80 - lo moves [lo, lo + 26) to the bottom of the signed range, so
+// one signed compare selects it.
+SIMD_TARGET("sse2")
+local void case_sse2(u8* dst, const u8* src, u64 length, u8 lo) {
+    __m128i shift = _mm_set1_epi8((char)(0x80 - lo));
+    __m128i limit = _mm_set1_epi8((char)(-128 + 26));
+    __m128i flip  = _mm_set1_epi8(0x20);
+    u64 i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i v        = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i in_range = _mm_cmplt_epi8(_mm_add_epi8(v, shift), limit);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(v, _mm_and_si128(in_range, flip)));
+    }
+    case_scalar(dst + i, src + i, length - i, lo);
+}
+
+SIMD_TARGET("avx2")
+local void case_avx2(u8* dst, const u8* src, u64 length, u8 lo) {
+    __m256i shift = _mm256_set1_epi8((char)(0x80 - lo));
+    __m256i limit = _mm256_set1_epi8((char)(-128 + 26));
+    __m256i flip  = _mm256_set1_epi8(0x20);
+    u64 i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i v        = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i in_range = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(v, shift));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_xor_si256(v, _mm256_and_si256(in_range, flip)));
+    }
+    case_sse2(dst + i, src + i, length - i, lo);
+}
+
+SIMD_TARGET("avx512f,avx512bw")
+local void case_avx512(u8* dst, const u8* src, u64 length, u8 lo) {
+    __m512i base = _mm512_set1_epi8((char)lo);
+    __m512i span = _mm512_set1_epi8(26);
+    __m512i flip = _mm512_set1_epi8(0x20);
+    for (u64 i = 0; i < length; i += 64) {
+        __mmask64 live     = length - i >= 64 ? ALL64 : (1ull << (length - i)) - 1;
+        __m512i   v        = _mm512_maskz_loadu_epi8(live, src + i);
+        __mmask64 in_range = _mm512_cmplt_epu8_mask(_mm512_sub_epi8(v, base), span);
+        v = _mm512_mask_blend_epi8(in_range, v, _mm512_xor_si512(v, flip));
+        _mm512_mask_storeu_epi8(dst + i, live, v);
+    }
+}
+
+SIMD_TARGET("sse2")
+local u64 pair_mask_sse2(const u8* p, u8 first, u8 last, u64 gap) {
+    __m128i f    = _mm_set1_epi8((char)first);
+    __m128i l    = _mm_set1_epi8((char)last);
+    u64     mask = 0;
+    for (u32 i = 0; i < 64; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(p + i + gap));
+        u64     m = (u32)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, f), _mm_cmpeq_epi8(b, l)));
+        mask |= m << i;
+    }
+    return mask;
+}
+
+SIMD_TARGET("avx2")
+local u64 pair_mask_avx2(const u8* p, u8 first, u8 last, u64 gap) {
+    __m256i f    = _mm256_set1_epi8((char)first);
+    __m256i l    = _mm256_set1_epi8((char)last);
+    u64     mask = 0;
+    for (u32 i = 0; i < 64; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(p + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(p + i + gap));
+        u64     m = (u32)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, f), _mm256_cmpeq_epi8(b, l)));
+        mask |= m << i;
+    }
+    return mask;
+}
+
+SIMD_TARGET("avx512f,avx512bw")
+local u64 pair_mask_avx512(const u8* p, u8 first, u8 last, u64 gap) {
+    __m512i a = _mm512_loadu_si512((const void*)p);
+    __m512i b = _mm512_loadu_si512((const void*)(p + gap));
+    return _mm512_cmpeq_epi8_mask(a, _mm512_set1_epi8((char)first)) &
+           _mm512_cmpeq_epi8_mask(b, _mm512_set1_epi8((char)last));
+}
+
+// UTF-8 validation by table lookups (Keiser and Lemire, "Validating UTF-8 In
+// Less Than One Instruction Per Byte", 2021). The high and low nibble of each
+// byte and the high nibble of the next one index three tables of error bits,
+// an error needs all three to agree. Sequence lengths are checked by looking
+// two and three bytes back for 3 and 4 byte leads.
+#define UTF8_TOO_SHORT      (1 << 0)
+#define UTF8_TOO_LONG       (1 << 1)
+#define UTF8_OVERLONG_3     (1 << 2)
+#define UTF8_TOO_LARGE      (1 << 3)
+#define UTF8_SURROGATE      (1 << 4)
+#define UTF8_OVERLONG_2     (1 << 5)
+#define UTF8_TOO_LARGE_1000 (1 << 6)
+#define UTF8_OVERLONG_4     (1 << 6)
+#define UTF8_TWO_CONTS      (1 << 7)
+#define UTF8_CARRY          (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+#define utf8_table(...) _mm256_setr_epi8(__VA_ARGS__, __VA_ARGS__)
+
+// `input` shifted right by `n` bytes, pulling the last bytes of `prev` in.
+#define utf8_prev(input, prev, n) _mm256_alignr_epi8((input), _mm256_permute2x128_si256((prev), (input), 0x21), 16 - (n))
+
+SIMD_TARGET("avx2")
+local __m256i utf8_check_avx2(__m256i input, __m256i prev_input) {
+    const __m256i byte_1_high_table = utf8_table(
+        UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+        UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+        UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+        UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+        UTF8_TOO_SHORT,
+        UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+        UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4);
+    const __m256i byte_1_low_table = utf8_table(
+        UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+        UTF8_CARRY | UTF8_OVERLONG_2,
+        UTF8_CARRY,
+        UTF8_CARRY,
+        UTF8_CARRY | UTF8_TOO_LARGE,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000);
+    const __m256i byte_2_high_table = utf8_table(
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+
+    __m256i prev1       = utf8_prev(input, prev_input, 1);
+    __m256i byte_1_high = _mm256_shuffle_epi8(byte_1_high_table, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+    __m256i byte_1_low  = _mm256_shuffle_epi8(byte_1_low_table, _mm256_and_si256(prev1, nibble));
+    __m256i byte_2_high = _mm256_shuffle_epi8(byte_2_high_table, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+    __m256i special     = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+    // Bytes two after a 3 or 4 byte lead, or three after a 4 byte lead, must
+    // be continuations: only those leads stay >= 0x80 after the subtraction.
+    __m256i third  = _mm256_subs_epu8(utf8_prev(input, prev_input, 2), _mm256_set1_epi8((char)(0xE0 - 0x80)));
+    __m256i fourth = _mm256_subs_epu8(utf8_prev(input, prev_input, 3), _mm256_set1_epi8((char)(0xF0 - 0x80)));
+    __m256i must23 = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+    return _mm256_xor_si256(must23, special);
+}
+
+SIMD_TARGET("avx2")
+local b8 utf8_validate_avx2(const u8* p, u64 length) {
+    // Nonzero when the block ends inside a multibyte sequence.
+    const __m256i max_value = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+    __m256i error      = _mm256_setzero_si256();
+    __m256i prev_input = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+
+    u8  tail[64];
+    u64 i = 0;
+    while (i < length) {
+        const u8* block = p + i;
+        if (length - i < 64) {
+            // Zero padding reads as ASCII, so a cut sequence still fails.
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, p + i, length - i);
+            block = tail;
+        }
+        __m256i a = _mm256_loadu_si256((const __m256i*)block);
+        __m256i b = _mm256_loadu_si256((const __m256i*)(block + 32));
+        i += 64;
+
+        if (_mm256_movemask_epi8(_mm256_or_si256(a, b)) == 0) {
+            error      = _mm256_or_si256(error, incomplete);
+            incomplete = _mm256_setzero_si256();
+            prev_input = b;
+            continue;
+        }
+        error      = _mm256_or_si256(error, utf8_check_avx2(a, prev_input));
+        error      = _mm256_or_si256(error, utf8_check_avx2(b, a));
+        incomplete = _mm256_subs_epu8(b, max_value);
+        prev_input = b;
+    }
+    error = _mm256_or_si256(error, incomplete);
+    return _mm256_testz_si256(error, error);
+}
+
+SIMD_TARGET("avx2")
+local u64 utf8_count_avx2(const u8* p, u64 length) {
+    // Continuation bytes are the signed range [-128, -65].
+    const __m256i limit = _mm256_set1_epi8(-65);
+    u64 count = 0;
+    u64 i     = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+        count += popcount_u64((u32)_mm256_movemask_epi8(_mm256_cmpgt_epi8(v, limit)));
+    }
+    return count + utf8_count_scalar(p + i, length - i);
+}
+
+typedef enum {
+    SIMD_SSE2,
+    SIMD_AVX2,
+    SIMD_AVX512,
+} SimdLevel;
+
+// Both the CPU and the OS (through XCR0) have to support the wider registers.
+local SimdLevel simd_level(void) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return SIMD_SSE2;
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27))) return SIMD_SSE2;
+    u64 xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    if ((info[1] & (1 << 30)) && (info[1] & (1 << 16)) && (xcr0 & 0xE6) == 0xE6) return SIMD_AVX512;
+    if ((info[1] & (1 << 5)) && (xcr0 & 0x6) == 0x6) return SIMD_AVX2;
+    return SIMD_SSE2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw")) return SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+    return SIMD_SSE2;
+#endif
+}
+#endif
+
+local u64  mismatch_resolve(const u8* a, const u8* b, u64 length);
+local void case_resolve(u8* dst, const u8* src, u64 length, u8 lo);
+local u64  pair_mask_resolve(const u8* p, u8 first, u8 last, u64 gap);
+local b8   utf8_validate_resolve(const u8* p, u64 length);
+local u64  utf8_count_resolve(const u8* p, u64 length);
+
+global MismatchFn     mismatch_impl      = mismatch_resolve;
+global CaseFn         case_impl          = case_resolve;
+global PairMaskFn     pair_mask_impl     = pair_mask_resolve;
+global Utf8ValidateFn utf8_validate_impl = utf8_validate_resolve;
+global Utf8CountFn    utf8_count_impl    = utf8_count_resolve;
+
+#if defined(__GNUC__)
+__attribute__((constructor))
+#endif
+local void string_kernels_init(void) {
+#if defined(SAMLIB_X86)
+    switch (simd_level()) {
+    case SIMD_AVX512:
+        mismatch_impl      = mismatch_avx512;
+        case_impl          = case_avx512;
+        pair_mask_impl     = pair_mask_avx512;
+        utf8_validate_impl = utf8_validate_avx2;
+        utf8_count_impl    = utf8_count_avx2;
+        break;
+    case SIMD_AVX2:
+        mismatch_impl      = mismatch_avx2;
+        case_impl          = case_avx2;
+        pair_mask_impl     = pair_mask_avx2;
+        utf8_validate_impl = utf8_validate_avx2;
+        utf8_count_impl    = utf8_count_avx2;
+        break;
+    case SIMD_SSE2:
+        mismatch_impl      = mismatch_sse2;
+        case_impl          = case_sse2;
+        pair_mask_impl     = pair_mask_sse2;
+        utf8_validate_impl = utf8_validate_scalar;
+        utf8_count_impl    = utf8_count_scalar;
+        break;
+    }
+#else
+    mismatch_impl      = mismatch_scalar;
+    case_impl          = case_scalar;
+    pair_mask_impl     = pair_mask_scalar;
+    utf8_validate_impl = utf8_validate_scalar;
+    utf8_count_impl    = utf8_count_scalar;
+#endif
+}
+
+// Compilers without constructors resolve on first call, every thread stores
+// the same pointers.
+local u64 mismatch_resolve(const u8* a, const u8* b, u64 length) {
+    string_kernels_init();
+    return mismatch_impl(a, b, length);
+}
+
+local void case_resolve(u8* dst, const u8* src, u64 length, u8 lo) {
+    string_kernels_init();
+    case_impl(dst, src, length, lo);
+}
+
+local u64 pair_mask_resolve(const u8* p, u8 first, u8 last, u64 gap) {
+    string_kernels_init();
+    return pair_mask_impl(p, first, last, gap);
+}
+
+local b8 utf8_validate_resolve(const u8* p, u64 length) {
+    string_kernels_init();
+    return utf8_validate_impl(p, length);
+}
+
+local u64 utf8_count_resolve(const u8* p, u64 length) {
+    string_kernels_init();
+    return utf8_count_impl(p, length);
+}
+
+void string_upper(String str) {
+    case_impl(str.buffer, str.buffer, str.length, 'a');
+}
+
+String string_upper_new(Arena* arena, const String str) {
+    u8* new_str = push_array(arena, u8, str.length);
+    case_impl(new_str, str.buffer, str.length, 'a');
+
+    return (String) {
+        .buffer = new_str,
+        .length = str.length,
+    };
+}
+
+void string_lower(String str) {
+    case_impl(str.buffer, str.buffer, str.length, 'A');
+}
+
+String string_lower_new(Arena* arena, const String str) {
+    u8* new_str = push_array(arena, u8, str.length);
+    case_impl(new_str, str.buffer, str.length, 'A');
+
+    return (String) {
+        .buffer = new_str,
+        .length = str.length,
+    };
+}
+
+b8 string_equals(const String str1, const String str2) {
+    if (str1.length != str2.length) return false;
+    return mismatch_impl(str1.buffer, str2.buffer, str1.length) == str1.length;
+}
+
+b8 string_cmp(const String str1, const char* str2) {
+    if (strnlen(str2, str1.length + 1) != str1.length) return false;
+    return mismatch_impl(str1.buffer, (const u8*)str2, str1.length) == str1.length;
+}
+
+s32 string_compare(const String str1, const String str2) {
+    u64 length = MIN(str1.length, str2.length);
+    u64 i      = mismatch_impl(str1.buffer, str2.buffer, length);
+    if (i < length) return (s32)str1.buffer[i] - (s32)str2.buffer[i];
+    return (str1.length > str2.length) - (str1.length < str2.length);
+}
+
+// Candidates come from matching the needle's first and last bytes 64
+// positions at a time, only those get a full compare (Mula's SIMD-friendly
+// substring search).
+local b8 needle_at(const u8* hay, const String needle) {
+    return needle.length <= 2 || memcmp(hay + 1, needle.buffer + 1, needle.length - 2) == 0;
+}
+
+u64 string_find_byte(const String str, u8 byte) {
+    u64 i = 0;
+    for (; i + 64 <= str.length; i += 64) {
+        u64 mask = pair_mask_impl(str.buffer + i, byte, byte, 0);
+        if (mask != 0) return i + lsb_index(mask);
+    }
+    for (; i < str.length; i++) {
+        if (str.buffer[i] == byte) return i;
+    }
+    return STRING_NOT_FOUND;
+}
+
+u64 string_find(const String str, const String needle) {
+    if (needle.length == 0) return 0;
+    if (needle.length > str.length) return STRING_NOT_FOUND;
+    if (needle.length == 1) return string_find_byte(str, needle.buffer[0]);
+
+    u8  first     = needle.buffer[0];
+    u64 gap       = needle.length - 1;
+    u8  last      = needle.buffer[gap];
+    u64 positions = str.length - gap;
+    u64 i = 0;
+    for (; i + 64 <= positions; i += 64) {
+        u64 mask = pair_mask_impl(str.buffer + i, first, last, gap);
+        while (mask != 0) {
+            u64 pos = i + lsb_index(mask);
+            if (needle_at(str.buffer + pos, needle)) return pos;
+            mask &= mask - 1;
+        }
+    }
+    for (; i < positions; i++) {
+        const u8* p = str.buffer + i;
+        if (p[0] == first && p[gap] == last && needle_at(p, needle)) return i;
+    }
+    return STRING_NOT_FOUND;
+}
+
+u64 string_rfind(const String str, const String needle) {
+    if (needle.length > str.length) return STRING_NOT_FOUND;
+    if (needle.length == 0) return str.length;
+
+    u8  first = needle.buffer[0];
+    u64 gap   = needle.length - 1;
+    u8  last  = needle.buffer[gap];
+    u64 end   = str.length - gap;
+    while (end >= 64) {
+        u64 i    = end - 64;
+        u64 mask = pair_mask_impl(str.buffer + i, first, last, gap);
+        while (mask != 0) {
+            u32 bit = msb_index(mask);
+            if (needle_at(str.buffer + i + bit, needle)) return i + bit;
+            mask ^= 1ull << bit;
+        }
+        end = i;
+    }
+    while (end-- > 0) {
+        const u8* p = str.buffer + end;
+        if (p[0] == first && p[gap] == last && needle_at(p, needle)) return end;
+    }
+    return STRING_NOT_FOUND;
+}
+
+b8 string_contains(const String str, const String needle) {
+    return string_find(str, needle) != STRING_NOT_FOUND;
+}
+
+StringSplitIter string_split(const String str, const String delim) {
+    return (StringSplitIter) {
+        .rest  = str,
+        .delim = delim,
+    };
+}
+
+StringSplitIter string_split_byte(const String str, u8 delim) {
+    return (StringSplitIter) {
+        .rest    = str,
+        .byte    = delim,
+        .by_byte = true,
+    };
+}
+
+b8 string_split_next(StringSplitIter* it, String* token) {
+    if (it->done) return false;
+
+    u64 skip = it->by_byte ? 1 : it->delim.length;
+    u64 idx;
+    if (it->by_byte) idx = string_find_byte(it->rest, it->byte);
+    else if (skip == 0) idx = STRING_NOT_FOUND;
+    else idx = string_find(it->rest, it->delim);
+
+    if (idx == STRING_NOT_FOUND) {
+        *token   = it->rest;
+        it->done = true;
+        return true;
+    }
+    *token   = str_slice_until(it->rest, idx);
+    it->rest = str_slice_end(it->rest, idx + skip);
+    return true;
+}
+
+b8 string_utf8_validate(const String str) {
+    return utf8_validate_impl(str.buffer, str.length);
+}
+
+u64 string_utf8_count(const String str) {
+    return utf8_count_impl(str.buffer, str.length);
+}
+
+Utf8Iter string_utf8_iter(const String str) {
+    return (Utf8Iter) {
+        .str = str,
+    };
+}
+
+b8 string_utf8_next(Utf8Iter* it, u32* codepoint) {
+    if (it->pos >= it->str.length) return false;
+
+    u32 n = utf8_decode(it->str.buffer + it->pos, it->str.length - it->pos, codepoint);
+    if (n == 0) {
+        *codepoint = UTF8_REPLACEMENT;
+        n          = 1;
+    }
+    it->pos += n;
+    return true;
+}
+
+StringBuilder string_builder(Arena* arena, u64 cap) {
+    u8* buffer = cap > 0 ? push_array(arena, u8, cap) : NULL;
+    return (StringBuilder) {
+        .arena = arena,
+        .str   = string_init(buffer),
+        .cap   = buffer != NULL ? cap : 0,
+    };
+}
+
+b8 string_builder_reserve(StringBuilder* sb, u64 extra) {
+    u64 needed = sb->str.length + extra;
+    if (needed <= sb->cap) return true;
+
+    u64 new_cap = MAX(MAX(sb->cap * 2, needed), 64);
+    // Extends in place when the buffer is still the arena's last allocation.
+    u8* buffer = arena_realloc(sb->arena, sb->str.buffer, sb->cap, new_cap, 1);
+    if (buffer == NULL && new_cap > needed) {
+        new_cap = needed;
+        buffer  = arena_realloc(sb->arena, sb->str.buffer, sb->cap, new_cap, 1);
+    }
+    // Out of arena space, the builder keeps what it has.
+    if (buffer == NULL) return false;
+    sb->str.buffer = buffer;
+    sb->cap        = new_cap;
+    return true;
+}
+
+void string_builder_bytes(StringBuilder* sb, const void* data, u64 length) {
+    if (length == 0 || !string_builder_reserve(sb, length)) return;
+    memcpy(sb->str.buffer + sb->str.length, data, length);
+    sb->str.length += length;
+}
+
+void string_builder_str(StringBuilder* sb, const char* s) { string_builder_bytes(sb, s, strlen(s)); }
+void string_builder_string(StringBuilder* sb, const String str) { string_builder_bytes(sb, str.buffer, str.length); }
+
+void string_builder_byte(StringBuilder* sb, u8 byte) {
+    if (!string_builder_reserve(sb, 1)) return;
+    sb->str.buffer[sb->str.length++] = byte;
+}
+
+void string_builder_s8(StringBuilder* sb, s8 val)   { if (string_builder_reserve(sb, BUILDER_INT_MAX)) string_write_s8(&sb->str, val); }
+void string_builder_s16(StringBuilder* sb, s16 val) { if (string_builder_reserve(sb, BUILDER_INT_MAX)) string_write_s16(&sb->str, val); }
+void string_builder_s32(StringBuilder* sb, s32 val) { if (string_builder_reserve(sb, BUILDER_INT_MAX)) string_write_s32(&sb->str, val); }
+void string_builder_s64(StringBuilder* sb, s64 val) { if (string_builder_reserve(sb, BUILDER_INT_MAX)) string_write_s64(&sb->str, val); }
+void string_builder_u8(StringBuilder* sb, u8 val)   { if (string_builder_reserve(sb, BUILDER_INT_MAX)) string_write_u8(&sb->str, val); }
+void string_builder_u16(StringBuilder* sb, u16 val) { if (string_builder_reserve(sb, BUILDER_INT_MAX)) string_write_u16(&sb->str, val); }
+void string_builder_u32(StringBuilder* sb, u32 val) { if (string_builder_reserve(sb, BUILDER_INT_MAX)) string_write_u32(&sb->str, val); }
+void string_builder_u64(StringBuilder* sb, u64 val) { if (string_builder_reserve(sb, BUILDER_INT_MAX)) string_write_u64(&sb->str, val); }
+void string_builder_f32(StringBuilder* sb, f32 val) { if (string_builder_reserve(sb, BUILDER_FLOAT_MAX)) string_write_f32(&sb->str, val); }
+void string_builder_f64(StringBuilder* sb, f64 val) { if (string_builder_reserve(sb, BUILDER_FLOAT_MAX)) string_write_f64(&sb->str, val); }
+
+void string_builder_f32_prec(StringBuilder* sb, f32 val, u32 precision) {
+    if (string_builder_reserve(sb, BUILDER_PREC_MAX)) string_write_f32_prec(&sb->str, val, precision);
+}
+
+void string_builder_f64_prec(StringBuilder* sb, f64 val, u32 precision) {
+    if (string_builder_reserve(sb, BUILDER_PREC_MAX)) string_write_f64_prec(&sb->str, val, precision);
+}
+
+void string_builder_hex(StringBuilder* sb, u64 val) {
+    if (string_builder_reserve(sb, 16)) string_write_hex(&sb->str, val);
+}
+
+void string_builder_ptr(StringBuilder* sb, const void* ptr) {
+    if (string_builder_reserve(sb, 18)) string_write_ptr(&sb->str, ptr);
+}
+
+void string_builder_newline(StringBuilder* sb) {
+    string_builder_byte(sb, '\n');
+}
+
+void string_builder_reset(StringBuilder* sb) {
+    sb->str.length = 0;
+}
+
+String string_builder_view(const StringBuilder* sb) {
+    return sb->str;
+}
+
+char* string_builder_cstr(StringBuilder* sb) {
+    if (!string_builder_reserve(sb, 1)) return NULL;
+    return string_to_cstr(&sb->str);
+}
+
+Writer writer_new(Arena* arena, FileHandle fd, u64 cap) {
+    u8* buffer = cap > 0 ? push_array(arena, u8, cap) : NULL;
+    return (Writer) {
+        .buffer = buffer,
+        .cap    = buffer != NULL ? cap : 0, // Unbuffered when the arena is full.
+        .fd     = fd,
+    };
+}
+
+// Output that does not fit goes out together with the buffered bytes in one
+// gathered write, so nothing large is ever copied.
+local void writer_gather(Writer* w, WriteChunk* chunks, u32 count) {
+    u64 total = 0;
+    for (u32 i = 0; i < count; i++) total += chunks[i].length;
+
+    if (w->length + total <= w->cap) {
+        for (u32 i = 0; i < count; i++) {
+            if (chunks[i].length == 0) continue;
+            memcpy(w->buffer + w->length, chunks[i].data, chunks[i].length);
+            w->length += chunks[i].length;
+        }
+        return;
+    }
+
+    WriteChunk all[4] = { { w->buffer, w->length } };
+    for (u32 i = 0; i < count; i++) all[i + 1] = chunks[i];
+    if (!os_write_chunks(w->fd, all, count + 1)) w->failed = true;
+    w->length = 0;
+}
+
+void writer_write(Writer* w, const void* data, u64 length) {
+    WriteChunk chunk = { data, length };
+    writer_gather(w, &chunk, 1);
+}
+
+void writer_print(Writer* w, const String str) {
+    WriteChunk chunk = { str.buffer, str.length };
+    writer_gather(w, &chunk, 1);
+}
+
+void writer_println(Writer* w, const String str) {
+    WriteChunk chunks[] = { { str.buffer, str.length }, { (const u8*)"\n", 1 } };
+    writer_gather(w, chunks, LEN(chunks));
+}
+
+b8 writer_flush(Writer* w) {
+    if (w->length > 0) {
+        WriteChunk chunk = { w->buffer, w->length };
+        if (!os_write_chunks(w->fd, &chunk, 1)) w->failed = true;
+        w->length = 0;
+    }
+    b8 ok     = !w->failed;
+    w->failed = false;
+    return ok;
+}
+
+#define STD_WRITER_SIZE KB(16)
+
+global Writer std_writers[2];
+global u8     std_writer_buffers[2][STD_WRITER_SIZE];
+
+local void std_writers_flush(void) {
+    writer_flush(&std_writers[0]);
+    writer_flush(&std_writers[1]);
+}
+
+local Writer* std_writer(u32 idx) {
+    Writer* w = &std_writers[idx];
+    if (w->buffer == NULL) {
+        if (std_writers[idx ^ 1].buffer == NULL) atexit(std_writers_flush);
+#if defined(__unix)
+        w->fd = idx + 1;
+#else
+        w->fd = GetStdHandle(idx == 0 ? STD_OUTPUT_HANDLE : STD_ERROR_HANDLE);
+#endif
+        w->cap    = STD_WRITER_SIZE;
+        w->buffer = std_writer_buffers[idx];
+    }
+    return w;
+}
+
+Writer* writer_stdout(void) {
+    return std_writer(0);
+}
+
+Writer* writer_stderr(void) {
+    return std_writer(1);
+}
+
+local u64 interner_hash(const String str) {
+    return string_hash(str, 0);
+}
+
+// Slots hold the upper half of the hash next to `id + 1` so most mismatches
+// are rejected without touching the bytes, 0 marks an empty slot.
+local u64 interner_slot(u64 hash, u32 id) {
+    return (hash & 0xFFFFFFFF00000000ull) | (u64)(id + 1);
+}
+
+local u32 interner_probe(const StringInterner* in, const String str, u64 hash, u64* slot_idx) {
+    *slot_idx = 0;
+    if (in->slot_count == 0) return INTERNER_NOT_FOUND;
+    u64 mask = in->slot_count - 1;
+    u64 idx  = hash & mask;
+    for (;;) {
+        u64 slot = in->slots[idx];
+        if (slot == 0) break;
+        if ((slot >> 32) == (hash >> 32)) {
+            u32 id = (u32)slot - 1;
+            if (string_equals(in->strings[id], str)) {
+                *slot_idx = idx;
+                return id;
+            }
+        }
+        idx = (idx + 1) & mask;
+    }
+    *slot_idx = idx;
+    return INTERNER_NOT_FOUND;
+}
+
+local b8 interner_grow(StringInterner* in) {
+    u32 new_count = MAX(in->slot_count * 2, 16);
+    u64* slots    = push_array(in->arena, u64, new_count);
+    if (slots == NULL) return false;
+    memset(slots, 0, new_count * sizeof(u64));
+    for (u32 i = 0; i < in->slot_count; i++) {
+        u64 slot = in->slots[i];
+        if (slot == 0) continue;
+        u32 id  = (u32)slot - 1;
+        u64 idx = in->hashes[id] & (new_count - 1);
+        while (slots[idx] != 0) idx = (idx + 1) & (new_count - 1);
+        slots[idx] = slot;
+    }
+    in->slots      = slots;
+    in->slot_count = new_count;
+    return true;
+}
+
+StringInterner interner_new(Arena* arena, u32 cap) {
+    u32 slot_count = 16;
+    while (slot_count / 4 * 3 < cap) slot_count *= 2;
+
+    StringInterner in = {
+        .arena      = arena,
+        .slots      = push_array(arena, u64, slot_count),
+        .slot_count = slot_count,
+    };
+    // Sized up front, so they don't start at zero and get copied on every
+    // doubling once string bytes sit above them in the arena.
+    if (cap > 0) {
+        in.strings = push_array(arena, String, cap);
+        in.hashes  = push_array(arena, u64, cap);
+        in.cap     = in.strings != NULL && in.hashes != NULL ? cap : 0;
+    }
+    // Failed allocations leave an empty table that grows on the first insert.
+    if (in.slots == NULL) in.slot_count = 0;
+    else memset(in.slots, 0, slot_count * sizeof(u64));
+    return in;
+}
+
+local u32 interner_insert(StringInterner* in, const String str, u64 hash) {
+    u64 idx;
+    u32 id = interner_probe(in, str, hash, &idx);
+    if (id != INTERNER_NOT_FOUND) return id;
+
+    // Every allocation happens before the table changes, so running out of
+    // arena space leaves it as it was.
+    if ((u64)(in->count + 1) * 4 > (u64)in->slot_count * 3) {
+        if (!interner_grow(in)) return INTERNER_NOT_FOUND;
+        interner_probe(in, str, hash, &idx);
+    }
+    if (in->count == in->cap) {
+        u32     new_cap = MAX(in->cap * 2, 16);
+        String* strings = arena_realloc(in->arena, in->strings, in->cap * sizeof(String), new_cap * sizeof(String), alignof(String));
+        if (strings == NULL) return INTERNER_NOT_FOUND;
+        in->strings = strings;
+        u64* hashes = arena_realloc(in->arena, in->hashes, in->cap * sizeof(u64), new_cap * sizeof(u64), alignof(u64));
+        if (hashes == NULL) return INTERNER_NOT_FOUND;
+        in->hashes = hashes;
+        in->cap    = new_cap;
+    }
+    u8* bytes = str.length > 0 ? push_array(in->arena, u8, str.length) : NULL;
+    if (str.length > 0 && bytes == NULL) return INTERNER_NOT_FOUND;
+
+    id = in->count++;
+    if (str.length > 0) memcpy(bytes, str.buffer, str.length);
+    in->strings[id] = (String) { bytes, str.length };
+    in->hashes[id]  = hash;
+    in->slots[idx]  = interner_slot(hash, id);
+    return id;
+}
+
+u32 interner_intern(StringInterner* in, const String str) {
+    return interner_insert(in, str, interner_hash(str));
+}
+
+u32 interner_find(const StringInterner* in, const String str) {
+    u64 idx;
+    return interner_probe(in, str, interner_hash(str), &idx);
+}
+
+String interner_get(const StringInterner* in, u32 id) {
+    return in->strings[id];
+}
+
+// Hashes a batch first and prefetches its home slots, so the probes overlap
+// their cache misses instead of taking them one at a time.
+void interner_intern_many(StringInterner* in, const String* strs, u32* ids, u64 count) {
+    u64 hashes[16];
+    for (u64 base = 0; base < count; base += LEN(hashes)) {
+        u64 batch = MIN(count - base, LEN(hashes));
+        for (u64 i = 0; i < batch; i++) {
+            hashes[i] = interner_hash(strs[base + i]);
+#if defined(__GNUC__)
+            if (in->slot_count > 0) __builtin_prefetch(&in->slots[hashes[i] & (in->slot_count - 1)]);
+#endif
+        }
+        for (u64 i = 0; i < batch; i++) {
+            ids[base + i] = interner_insert(in, strs[base + i], hashes[i]);
+        }
+    }
+}
+
+local b8 is_digit(u8 c) {
+    return (u8)(c - '0') < 10;
+}
+
+// True when all eight bytes of `chunk` are ASCII digits.
+local b8 swar_all_digits(u64 chunk) {
+    return ((chunk & 0xF0F0F0F0F0F0F0F0ull) |
+            (((chunk + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull;
+}
+
+// Eight ASCII digits loaded little endian into their value, three multiplies
+// instead of eight.
+local u64 swar_parse8(u64 chunk) {
+    chunk -= 0x3030303030303030ull;
+    chunk  = (chunk * 10) + (chunk >> 8);
+    chunk  = (((chunk & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) +
+              (((chunk >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+    return chunk;
+}
+
+// Parses the digit run at `buf[pos..length)` into `*value`, saturating at
+// MAX_U64. Returns the position after the last digit.
+local u64 parse_digits(const u8* buf, u64 pos, u64 length, u64* value, b8* overflow) {
+    u64 result = 0;
+    *overflow  = false;
+
+    while (pos + 8 <= length && load_u64(buf + pos) == 0x3030303030303030ull) pos += 8;
+    while (pos < length && buf[pos] == '0') pos++;
+
+    // Nineteen digits always fit, so the SWAR steps need no overflow checks.
+    u64 safe_end = pos + 19 < length ? pos + 19 : length;
+    while (pos + 8 <= safe_end) {
+        u64 chunk = load_u64(buf + pos);
+        if (!swar_all_digits(chunk)) break;
+        result = result * 100000000 + swar_parse8(chunk);
+        pos   += 8;
+    }
+    while (pos < length && is_digit(buf[pos])) {
+        u64 digit = buf[pos] - '0';
+        if (!*overflow && result > (MAX_U64 - digit) / 10) {
+            *overflow = true;
+            result    = MAX_U64;
+        }
+        if (!*overflow) result = result * 10 + digit;
+        pos++;
+    }
+
+    *value = result;
+    return pos;
+}
+
+local u64 skip_blanks(const String str) {
+    u64 pos = 0;
+    while (pos < str.length && (str.buffer[pos] == ' ' || str.buffer[pos] == '\t')) pos++;
+    return pos;
+}
+
+local ParseResult parse_unsigned(const String str, u64 max) {
+    ParseResult result = { .status = PARSE_INVALID };
+    u64 pos = skip_blanks(str);
+    if (pos < str.length && str.buffer[pos] == '+') pos++;
+    if (pos >= str.length || !is_digit(str.buffer[pos])) return result;
+
+    b8  overflow;
+    u64 value;
+    result.consumed = parse_digits(str.buffer, pos, str.length, &value, &overflow);
+    if (overflow || value > max) {
+        result.status = PARSE_OVERFLOW;
+        result.u      = max;
+    } else {
+        result.status = PARSE_OK;
+        result.u      = value;
+    }
+    return result;
+}
+
+// `max` is the largest positive value, the negative limit is one further.
+local ParseResult parse_signed(const String str, u64 max) {
+    ParseResult result = { .status = PARSE_INVALID };
+    u64 pos = skip_blanks(str);
+    b8  negative = false;
+    if (pos < str.length && (str.buffer[pos] == '-' || str.buffer[pos] == '+')) {
+        negative = str.buffer[pos] == '-';
+        pos++;
+    }
+    if (pos >= str.length || !is_digit(str.buffer[pos])) return result;
+
+    b8  overflow;
+    u64 value;
+    u64 limit = max + negative;
+    result.consumed = parse_digits(str.buffer, pos, str.length, &value, &overflow);
+    result.status   = PARSE_OK;
+    if (overflow || value > limit) {
+        result.status = PARSE_OVERFLOW;
+        value         = limit;
+    }
+    result.s = negative ? (s64)(0 - value) : (s64)value;
+    return result;
+}
+
+ParseResult string_parse_s8(const String str) {
+    return parse_signed(str, MAX_S8);
+}
+
+ParseResult string_parse_s16(const String str) {
+    return parse_signed(str, MAX_S16);
+}
+
+ParseResult string_parse_s32(const String str) {
+    return parse_signed(str, MAX_S32);
+}
+
+ParseResult string_parse_s64(const String str) {
+    return parse_signed(str, MAX_S64);
+}
+
+ParseResult string_parse_u8(const String str) {
+    return parse_unsigned(str, MAX_U8);
+}
+
+ParseResult string_parse_u16(const String str) {
+    return parse_unsigned(str, MAX_U16);
+}
+
+ParseResult string_parse_u32(const String str) {
+    return parse_unsigned(str, MAX_U32);
+}
+
+ParseResult string_parse_u64(const String str) {
+    return parse_unsigned(str, MAX_U64);
+}
+
+s8 string_to_s8(const String str) {
+    return (s8)string_parse_s8(str).s;
+}
+
+s16 string_to_s16(const String str) {
+    return (s16)string_parse_s16(str).s;
+}
+
+s32 string_to_s32(const String str) {
+    return (s32)string_parse_s32(str).s;
+}
+
+s64 string_to_s64(const String str) {
+    return string_parse_s64(str).s;
+}
+
+u8 string_to_u8(const String str) {
+    return (u8)string_parse_u8(str).u;
+}
+
+u16 string_to_u16(const String str) {
+    return (u16)string_parse_u16(str).u;
+}
+
+u32 string_to_u32(const String str) {
+    return (u32)string_parse_u32(str).u;
+}
+
+u64 string_to_u64(const String str) {
+    return string_parse_u64(str).u;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                   FILES                                   */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#define FILE_READ_CHUNK KB(64)
+
+// Pipes, character devices and anything else that cannot be mapped is read
+// into the arena, growing the top allocation in place.
+local String file_read_fallback(Arena* arena, FileHandle fd) {
+    String data = { 0 };
+    if (arena == NULL) return data;
+
+    // A failed read gives back everything it took from the arena.
+    u64 start  = arena_pos(arena);
+    u64 cap    = FILE_READ_CHUNK;
+    u8* buffer = push_array(arena, u8, cap);
+    if (buffer == NULL) return data;
+    u64 length = 0;
+    b8  ok     = true;
+    for (;;) {
+        if (length == cap) {
+            u8* grown = arena_realloc(arena, buffer, cap, cap * 2, 1);
+            if (grown == NULL) {
+                ok = false;
+                break;
+            }
+            buffer = grown;
+            cap   *= 2;
+        }
+#if defined(__unix)
+        ssize_t got = read(fd, buffer + length, cap - length);
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) {
+            ok = false;
+            break;
+        }
+#else
+        DWORD got = 0;
+        if (!ReadFile(fd, buffer + length, (DWORD)MIN(cap - length, MAX_U32), &got, NULL) &&
+            GetLastError() != ERROR_BROKEN_PIPE) {
+            ok = false;
+            break;
+        }
+#endif
+        if (got == 0) break;
+        length += got;
+    }
+    if (!ok) {
+        arena_pop_to(arena, start);
+        return data;
+    }
+    // Hand back the slack when the buffer is still on top.
+    arena_realloc(arena, buffer, cap, length, 1);
+
+    data.buffer = buffer;
+    data.length = length;
+    return data;
+}
+
+MappedFile file_map(const char* path, Arena* fallback) {
+    persist u8 empty[1];
+    MappedFile file = { 0 };
+
+#if defined(__unix)
+    s32 fd = open(path, O_RDONLY);
+    if (fd < 0) return file;
+    struct stat st;
+    b8 regular = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    // procfs and sysfs files report a size of 0 yet have content, so empty
+    // regular files are read like pipes.
+    b8 sized   = regular && st.st_size > 0;
+    if (sized) {
+        u8* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, st.st_size, MADV_SEQUENTIAL);
+            madvise(map, st.st_size, MADV_WILLNEED);
+            close(fd);
+            file.data   = (String) { map, (u64)st.st_size };
+            file.mapped = true;
+            return file;
+        }
+    }
+    // Without an arena to read into, an empty regular file is taken at its word.
+    if (regular && !sized && fallback == NULL) file.data.buffer = empty;
+    else file.data = file_read_fallback(fallback, fd);
+    close(fd);
+#else
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle == INVALID_HANDLE_VALUE) return file;
+    LARGE_INTEGER size;
+    b8 regular = GetFileType(handle) == FILE_TYPE_DISK && GetFileSizeEx(handle, &size);
+    // Files reporting 0 bytes may still produce data, they are read instead.
+    b8 sized   = regular && size.QuadPart > 0;
+    if (sized) {
+        HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL) {
+            u8* map = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+            if (map != NULL) {
+                CloseHandle(handle);
+                file.data   = (String) { map, (u64)size.QuadPart };
+                file.mapped = true;
+                return file;
+            }
+        }
+    }
+    // Without an arena to read into, an empty regular file is taken at its word.
+    if (regular && !sized && fallback == NULL) file.data.buffer = empty;
+    else file.data = file_read_fallback(fallback, handle);
+    CloseHandle(handle);
+#endif
+    if (file.data.buffer == NULL) file.data.length = 0;
+    else if (file.data.length == 0) file.data.buffer = empty;
+    return file;
+}
+
+void file_unmap(MappedFile* file) {
+    if (file->mapped) {
+#if defined(__unix)
+        munmap(file->data.buffer, file->data.length);
+#else
+        UnmapViewOfFile(file->data.buffer);
+#endif
+    }
+    file->data   = (String) { 0 };
+    file->mapped = false;
+}
+
+#define LINE_READER_CHUNKS        4
+#define LINE_READER_DEFAULT_CHUNK MB(1)
+
+// A background thread fills a ring of chunks, one read per chunk like `cat`,
+// while the consumer slices lines out of them. `produced` and `consumed` only
+// grow, chunk i lives in slot i % LINE_READER_CHUNKS.
+struct LineReader {
+    FileHandle    fd;
+    u8*           chunks[LINE_READER_CHUNKS];
+    u64           lengths[LINE_READER_CHUNKS];
+    u64           chunk_size;
+    u64           produced;
+    u64           consumed;
+    b8            eof;
+    b8            failed;
+    b8            stop;
+
+    // Consumer side.
+    u8*           current;
+    u64           current_length;
+    u64           pos;
+    b8            holding;
+    StringBuilder stitch;    // Lines crossing a chunk boundary.
+    b8            truncated; // A stitched line did not fit the arena.
+
+#if defined(__unix)
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  ready;   // A chunk was produced or the input ended.
+    pthread_cond_t  drained; // A chunk was handed back.
+#else
+    HANDLE             thread;
+    CRITICAL_SECTION   lock;
+    CONDITION_VARIABLE ready;
+    CONDITION_VARIABLE drained;
+#endif
+};
+
+#if defined(__unix)
+    #define sync_lock(r)         pthread_mutex_lock(&(r)->lock)
+    #define sync_unlock(r)       pthread_mutex_unlock(&(r)->lock)
+    #define sync_wait(r, cond)   pthread_cond_wait(&(r)->cond, &(r)->lock)
+    #define sync_signal(r, cond) pthread_cond_signal(&(r)->cond)
+#else
+    #define sync_lock(r)         EnterCriticalSection(&(r)->lock)
+    #define sync_unlock(r)       LeaveCriticalSection(&(r)->lock)
+    #define sync_wait(r, cond)   SleepConditionVariableCS(&(r)->cond, &(r)->lock, INFINITE)
+    #define sync_signal(r, cond) WakeConditionVariable(&(r)->cond)
+#endif
+
+#if defined(__unix)
+local void* line_reader_thread(void* arg) {
+#else
+local DWORD WINAPI line_reader_thread(void* arg) {
+#endif
+    LineReader* r = arg;
+    for (;;) {
+        sync_lock(r);
+        while (r->produced - r->consumed == LINE_READER_CHUNKS && !r->stop) sync_wait(r, drained);
+        b8  stop = r->stop;
+        u64 slot = r->produced % LINE_READER_CHUNKS;
+        sync_unlock(r);
+        if (stop) break;
+
+        s64 got;
+#if defined(__unix)
+        do {
+            got = read(r->fd, r->chunks[slot], r->chunk_size);
+        } while (got < 0 && errno == EINTR);
+#else
+        DWORD count = 0;
+        b8    ok    = ReadFile(r->fd, r->chunks[slot], (DWORD)MIN(r->chunk_size, MAX_U32), &count, NULL);
+        // The write end closing a pipe is the end of input, not an error.
+        got = ok || GetLastError() == ERROR_BROKEN_PIPE ? (s64)count : -1;
+#endif
+
+        sync_lock(r);
+        if (got > 0) {
+            r->lengths[slot] = (u64)got;
+            r->produced++;
+        } else {
+            r->eof    = true;
+            r->failed = got < 0;
+        }
+        sync_signal(r, ready);
+        sync_unlock(r);
+        if (got <= 0) break;
+    }
+    return 0;
+}
+
+LineReader* line_reader_new(Arena* arena, FileHandle fd, u64 chunk_size) {
+    if (chunk_size == 0) chunk_size = LINE_READER_DEFAULT_CHUNK;
+
+    LineReader* r = push_type(arena, LineReader);
+    if (r == NULL) return NULL;
+    memset(r, 0, sizeof(*r));
+    r->fd         = fd;
+    r->chunk_size = chunk_size;
+    r->stitch     = string_builder(arena, 0);
+    for (u32 i = 0; i < LINE_READER_CHUNKS; i++) {
+        r->chunks[i] = push_array(arena, u8, chunk_size);
+        if (r->chunks[i] == NULL) return NULL;
+    }
+
+#if defined(__unix)
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->ready, NULL);
+    pthread_cond_init(&r->drained, NULL);
+    if (pthread_create(&r->thread, NULL, line_reader_thread, r) != 0) return NULL;
+#else
+    InitializeCriticalSection(&r->lock);
+    InitializeConditionVariable(&r->ready);
+    InitializeConditionVariable(&r->drained);
+    r->thread = CreateThread(NULL, 0, line_reader_thread, r, 0, NULL);
+    if (r->thread == NULL) return NULL;
+#endif
+    return r;
+}
+
+local b8 line_reader_acquire(LineReader* r) {
+    sync_lock(r);
+    while (r->consumed == r->produced && !r->eof) sync_wait(r, ready);
+    b8 have = r->consumed < r->produced;
+    sync_unlock(r);
+    if (!have) return false;
+
+    u64 slot          = r->consumed % LINE_READER_CHUNKS;
+    r->current        = r->chunks[slot];
+    r->current_length = r->lengths[slot];
+    r->pos            = 0;
+    r->holding        = true;
+    return true;
+}
+
+local void line_reader_release(LineReader* r) {
+    if (!r->holding) return;
+    sync_lock(r);
+    r->consumed++;
+    sync_signal(r, drained);
+    sync_unlock(r);
+    r->holding = false;
+}
+
+// A line the arena cannot hold ends the input, `line_reader_close` reports it.
+local b8 line_reader_stitch(LineReader* r, const u8* data, u64 length) {
+    if (!string_builder_reserve(&r->stitch, length)) {
+        r->truncated = true;
+        return false;
+    }
+    string_builder_bytes(&r->stitch, data, length);
+    return true;
+}
+
+b8 line_reader_next(LineReader* r, String* line) {
+    if (r->truncated) return false;
+    string_builder_reset(&r->stitch);
+    b8 stitched = false;
+    for (;;) {
+        if (!r->holding || r->pos == r->current_length) {
+            line_reader_release(r);
+            if (!line_reader_acquire(r)) {
+                *line = string_builder_view(&r->stitch);
+                return stitched;
+            }
+        }
+
+        String rest = { r->current + r->pos, r->current_length - r->pos };
+        u64    idx  = string_find_byte(rest, '\n');
+        if (idx != STRING_NOT_FOUND) {
+            r->pos += idx + 1;
+            if (!stitched) {
+                *line = str_slice_until(rest, idx);
+                return true;
+            }
+            if (!line_reader_stitch(r, rest.buffer, idx)) return false;
+            *line = string_builder_view(&r->stitch);
+            return true;
+        }
+        if (!line_reader_stitch(r, rest.buffer, rest.length)) return false;
+        r->pos   = r->current_length;
+        stitched = true;
+    }
+}
+
+b8 line_reader_close(LineReader* r) {
+    sync_lock(r);
+    r->stop = true;
+    sync_signal(r, drained);
+    sync_unlock(r);
+
+#if defined(__unix)
+    pthread_join(r->thread, NULL);
+    pthread_mutex_destroy(&r->lock);
+    pthread_cond_destroy(&r->ready);
+    pthread_cond_destroy(&r->drained);
+#else
+    WaitForSingleObject(r->thread, INFINITE);
+    CloseHandle(r->thread);
+    DeleteCriticalSection(&r->lock);
+#endif
+    return !r->failed && !r->truncated;
+}
+
+#define ASYNC_WRITER_DEFAULT_BUFFERS 8
+#define ASYNC_WRITER_DEFAULT_SIZE    KB(256)
+
+// Every buffer is in exactly one place: the free stack, `current`, the pending
+// ring (full, not yet handed to the disk) or in flight. io_uring is driven
+// from the caller's thread, the fallback thread drains the pending ring.
+struct AsyncWriter {
+    FileHandle fd;
+    u8**       buffers;
+    u64*       lengths;      // Bytes filled, per buffer.
+    u64*       written;      // Bytes the disk has taken, per buffer.
+    u64*       offsets;      // File offset of each buffer in positional mode.
+    u32*       free;
+    u32*       pending;      // Slot i % buffer_count, in file order.
+    u64        buffer_size;
+    u32        buffer_count;
+    u32        free_count;
+    u64        pending_head;
+    u64        pending_tail;
+    u32        current;      // Buffer being filled, ALL32 when none.
+    b8         failed;
+    b8         stop;
+    b8         uring;
+
+#if defined(SAMLIB_URING)
+    // A regular file without O_APPEND: buffers go out together at explicit
+    // offsets. Otherwise one write is in flight at a time to keep the order.
+    b8                   positional;
+    b8                   broken;      // io_uring_enter failed, writes are dropped.
+    u64                  offset;
+    u32                  batch;       // Placed writes collected per submission.
+    u32                  in_flight;
+    u32                  unsubmitted;
+    s32                  ring_fd;
+    u32*                 sq_tail;
+    u32*                 sq_array;
+    u32                  sq_mask;
+    struct io_uring_sqe* sqes;
+    u32*                 cq_head;
+    u32*                 cq_tail;
+    u32                  cq_mask;
+    struct io_uring_cqe* cqes;
+    u8*                  sq_ring;
+    u8*                  cq_ring;
+    u64                  sq_ring_size;
+    u64                  cq_ring_size;
+    u64                  sqes_size;
+#endif
+
+#if defined(__unix)
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  ready;   // A buffer was queued or the writer is closing.
+    pthread_cond_t  drained; // A buffer was written and freed.
+#else
+    HANDLE             thread;
+    CRITICAL_SECTION   lock;
+    CONDITION_VARIABLE ready;
+    CONDITION_VARIABLE drained;
+#endif
+};
+
+#if defined(SAMLIB_URING)
+local b8 uring_setup(AsyncWriter* w) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    s32 fd = (s32)syscall(__NR_io_uring_setup, w->buffer_count, &params);
+    if (fd < 0) return false;
+    // Writes at the current position (pipes, O_APPEND) need 5.6, as does
+    // IORING_OP_WRITE itself.
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+        close(fd);
+        return false;
+    }
+
+    w->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+    w->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    w->sqes_size    = params.sq_entries * sizeof(struct io_uring_sqe);
+    b8 single       = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) w->sq_ring_size = w->cq_ring_size = MAX(w->sq_ring_size, w->cq_ring_size);
+
+    u8* sq_ring = mmap(NULL, w->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_SQ_RING);
+    u8* cq_ring = single ? sq_ring : mmap(NULL, w->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_CQ_RING);
+    u8* sqes    = mmap(NULL, w->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_SQES);
+    if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sqes == MAP_FAILED) {
+        if (sq_ring != MAP_FAILED) munmap(sq_ring, w->sq_ring_size);
+        if (!single && cq_ring != MAP_FAILED) munmap(cq_ring, w->cq_ring_size);
+        if (sqes != MAP_FAILED) munmap(sqes, w->sqes_size);
+        close(fd);
+        return false;
+    }
 
-void temp_arena_end(TempArena temp) {
-	temp.arena->pos = temp.pos;
+    w->ring_fd  = fd;
+    w->sq_ring  = sq_ring;
+    w->cq_ring  = cq_ring;
+    w->sq_tail  = (u32*)(sq_ring + params.sq_off.tail);
+    w->sq_array = (u32*)(sq_ring + params.sq_off.array);
+    w->sq_mask  = *(u32*)(sq_ring + params.sq_off.ring_mask);
+    w->sqes     = (struct io_uring_sqe*)sqes;
+    w->cq_head  = (u32*)(cq_ring + params.cq_off.head);
+    w->cq_tail  = (u32*)(cq_ring + params.cq_off.tail);
+    w->cq_mask  = *(u32*)(cq_ring + params.cq_off.ring_mask);
+    w->cqes     = (struct io_uring_cqe*)(cq_ring + params.cq_off.cqes);
+    return true;
 }
 
-String string_init(u8* buffer) {
-    return (String) {
-        .buffer = buffer,
-        .length = 0,
-    };
+local void uring_teardown(AsyncWriter* w) {
+    munmap(w->sqes, w->sqes_size);
+    if (w->cq_ring != w->sq_ring) munmap(w->cq_ring, w->cq_ring_size);
+    munmap(w->sq_ring, w->sq_ring_size);
+    close(w->ring_fd);
 }
 
-void string_write_str(String* str, const char* s) {
-    u64 length = 0;
-    while (s[length]) length += 1;
-    memcpy(str->buffer + str->length, s, length);
-    str->length += length;
+// Queues the unwritten rest of a buffer. The ring has an entry per buffer and
+// a buffer is never queued twice, so there is always room.
+local void uring_place(AsyncWriter* w, u32 idx) {
+    u32                  tail = *w->sq_tail;
+    u32                  slot = tail & w->sq_mask;
+    struct io_uring_sqe* sqe  = &w->sqes[slot];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = IORING_OP_WRITE;
+    sqe->fd        = w->fd;
+    sqe->addr      = (u64)(w->buffers[idx] + w->written[idx]);
+    sqe->len       = (u32)(w->lengths[idx] - w->written[idx]);
+    sqe->off       = w->positional ? w->offsets[idx] + w->written[idx] : ALL64;
+    sqe->user_data = idx;
+    w->sq_array[slot] = slot;
+    __atomic_store_n(w->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    w->in_flight++;
+    w->unsubmitted++;
 }
 
-void string_write_s8(String* str, s8 val) {
-    u64 length = 0;
-    b8 neg = (val < 0);
-    if (neg) {
-        str->buffer[str->length + length] = '-';
-        str->length += 1;
-        val = -val;
-    }
-    if (val == 0) {
-        str->buffer[str->length + length] = '0';
-        str->length += 1;
+// Moves pending buffers into the ring, submits once a batch has built up and
+// recycles finished buffers. Blocks for up to `wait` completions.
+local void uring_pump(AsyncWriter* w, u32 wait) {
+    while (w->pending_head < w->pending_tail && (w->positional || w->in_flight == 0)) {
+        uring_place(w, w->pending[w->pending_head++ % w->buffer_count]);
     }
-    s8 aux_val = val;
-    while (aux_val != 0) {
-        aux_val /= 10;
-        length += 1;
+
+    wait = MIN(wait, w->in_flight);
+    if (wait > 0 || w->unsubmitted >= w->batch) {
+        s32 ret = (s32)syscall(__NR_io_uring_enter, w->ring_fd, w->unsubmitted, wait,
+                               wait > 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (ret >= 0) {
+            w->unsubmitted -= (u32)ret;
+        } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            // Nothing will complete anymore, give every buffer back.
+            w->broken       = true;
+            w->failed       = true;
+            w->in_flight    = 0;
+            w->unsubmitted  = 0;
+            w->pending_head = w->pending_tail;
+            w->free_count   = 0;
+            for (u32 i = 0; i < w->buffer_count; i++) {
+                if (i != w->current) w->free[w->free_count++] = i;
+            }
+            return;
+        }
     }
-    for (s32 i = length - 1; i >= 0; i--) {
-        str->buffer[str->length + i] = '0' + (val % 10);
-        val /= 10;
+
+    u32 head = *w->cq_head;
+    u32 tail = __atomic_load_n(w->cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+        struct io_uring_cqe* cqe = &w->cqes[head & w->cq_mask];
+        u32                  idx = (u32)cqe->user_data;
+        s32                  res = cqe->res;
+        w->in_flight--;
+        if (res == -EINTR || res == -EAGAIN) {
+            uring_place(w, idx);
+            continue;
+        }
+        if (res <= 0) {
+            w->failed       = true;
+            w->written[idx] = w->lengths[idx];
+        } else {
+            w->written[idx] += (u64)res;
+        }
+        if (w->written[idx] < w->lengths[idx]) uring_place(w, idx);
+        else w->free[w->free_count++] = idx;
     }
-    str->length += length;
+    __atomic_store_n(w->cq_head, head, __ATOMIC_RELEASE);
 }
+#endif
 
-void string_write_s16(String* str, s16 val) {
-    u64 length = 0;
-    b8 neg = (val < 0);
-    if (neg) {
-        str->buffer[str->length + length] = '-';
-        str->length += 1;
-        val = -val;
-    }
-    if (val == 0) {
-        str->buffer[str->length + length] = '0';
-        str->length += 1;
-    }
-    s16 aux_val = val;
-    while (aux_val != 0) {
-        aux_val /= 10;
-        length += 1;
-    }
-    for (s32 i = length - 1; i >= 0; i--) {
-        str->buffer[str->length + i] = '0' + (val % 10);
-        val /= 10;
+#if defined(__unix)
+local void* async_writer_thread(void* arg) {
+#else
+local DWORD WINAPI async_writer_thread(void* arg) {
+#endif
+    AsyncWriter* w = arg;
+    for (;;) {
+        sync_lock(w);
+        while (w->pending_head == w->pending_tail && !w->stop) sync_wait(w, ready);
+        b8  idle = w->pending_head == w->pending_tail;
+        u32 idx  = w->pending[w->pending_head % w->buffer_count];
+        sync_unlock(w);
+        if (idle) break;
+
+        WriteChunk chunk = { w->buffers[idx], w->lengths[idx] };
+        b8         ok    = os_write_chunks(w->fd, &chunk, 1);
+
+        sync_lock(w);
+        w->pending_head++;
+        w->failed                 |= !ok;
+        w->free[w->free_count++]   = idx;
+        sync_signal(w, drained);
+        sync_unlock(w);
     }
-    str->length += length;
+    return 0;
 }
 
-void string_write_s32(String* str, s32 val) {
-    u64 length = 0;
-    b8 neg = (val < 0);
-    if (neg) {
-        str->buffer[str->length + length] = '-';
-        str->length += 1;
-        val = -val;
-    }
-    if (val == 0) {
-        str->buffer[str->length + length] = '0';
-        str->length += 1;
+AsyncWriter* async_writer_new(Arena* arena, FileHandle fd, u64 buffer_size, u32 buffer_count) {
+    if (buffer_size == 0) buffer_size = ASYNC_WRITER_DEFAULT_SIZE;
+    if (buffer_count == 0) buffer_count = ASYNC_WRITER_DEFAULT_BUFFERS;
+    // A single write request carries at most 4GB.
+    buffer_size = MIN(buffer_size, MAX_U32);
+
+    AsyncWriter* w = push_type(arena, AsyncWriter);
+    if (w == NULL) return NULL;
+    memset(w, 0, sizeof(*w));
+    w->fd           = fd;
+    w->buffer_size  = buffer_size;
+    w->buffer_count = buffer_count;
+    w->current      = ALL32;
+    w->buffers      = push_array(arena, u8*, buffer_count);
+    w->lengths      = push_array(arena, u64, buffer_count);
+    w->written      = push_array(arena, u64, buffer_count);
+    w->offsets      = push_array(arena, u64, buffer_count);
+    w->free         = push_array(arena, u32, buffer_count);
+    w->pending      = push_array(arena, u32, buffer_count);
+    if (w->buffers == NULL || w->lengths == NULL || w->written == NULL || w->offsets == NULL || w->free == NULL ||
+        w->pending == NULL) {
+        return NULL;
     }
-    s32 aux_val = val;
-    while (aux_val != 0) {
-        aux_val /= 10;
-        length += 1;
+    for (u32 i = 0; i < buffer_count; i++) {
+        w->buffers[i] = push_array(arena, u8, buffer_size);
+        if (w->buffers[i] == NULL) return NULL;
+        w->free[i] = buffer_count - 1 - i;
     }
-    for (s32 i = length - 1; i >= 0; i--) {
-        str->buffer[str->length + i] = '0' + (val % 10);
-        val /= 10;
+    w->free_count = buffer_count;
+
+#if defined(SAMLIB_URING)
+    if (uring_setup(w)) {
+        struct stat st;
+        s64         pos = lseek(fd, 0, SEEK_CUR);
+        s32         fl  = fcntl(fd, F_GETFL);
+        w->uring        = true;
+        w->positional   = fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && pos >= 0 && fl >= 0 && !(fl & O_APPEND);
+        w->offset       = w->positional ? (u64)pos : 0;
+        w->batch        = w->positional ? MAX(buffer_count / 2, 1) : 1;
+        return w;
     }
-    str->length += length;
+#endif
+
+#if defined(__unix)
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->ready, NULL);
+    pthread_cond_init(&w->drained, NULL);
+    if (pthread_create(&w->thread, NULL, async_writer_thread, w) != 0) return NULL;
+#else
+    InitializeCriticalSection(&w->lock);
+    InitializeConditionVariable(&w->ready);
+    InitializeConditionVariable(&w->drained);
+    w->thread = CreateThread(NULL, 0, async_writer_thread, w, 0, NULL);
+    if (w->thread == NULL) return NULL;
+#endif
+    return w;
 }
 
-void string_write_s64(String* str, s64 val) {
-    u64 length = 0;
-    b8 neg = (val < 0);
-    if (neg) {
-        str->buffer[str->length + length] = '-';
-        str->length += 1;
-        val = -val;
-    }
-    if (val == 0) {
-        str->buffer[str->length + length] = '0';
-        str->length += 1;
+local u32 async_writer_acquire(AsyncWriter* w) {
+#if defined(SAMLIB_URING)
+    if (w->uring) {
+        while (w->free_count == 0) uring_pump(w, 1);
+        return w->free[--w->free_count];
     }
-    s64 aux_val = val;
-    while (aux_val != 0) {
-        aux_val /= 10;
-        length += 1;
-    }
-    for (s32 i = length - 1; i >= 0; i--) {
-        str->buffer[str->length + i] = '0' + (val % 10);
-        val /= 10;
-    }
-    str->length += length;
+#endif
+    sync_lock(w);
+    while (w->free_count == 0) sync_wait(w, drained);
+    u32 idx = w->free[--w->free_count];
+    sync_unlock(w);
+    return idx;
 }
 
-void string_write_u16(String* str, u16 val) {
-    u64 length = 0;
-    if (val == 0) {
-        str->buffer[str->length + length] = '0';
-        str->length += 1;
-    }
-    u16 aux_val = val;
-    while (aux_val != 0) {
-        aux_val /= 10;
-        length += 1;
-    }
-    for (s32 i = length - 1; i >= 0; i--) {
-        str->buffer[str->length + i] = '0' + (val % 10);
-        val /= 10;
+local void async_writer_submit(AsyncWriter* w) {
+    u32 idx         = w->current;
+    w->current      = ALL32;
+    w->written[idx] = 0;
+#if defined(SAMLIB_URING)
+    if (w->uring) {
+        if (w->broken) {
+            w->failed                = true;
+            w->free[w->free_count++] = idx;
+            return;
+        }
+        w->offsets[idx]  = w->offset;
+        w->offset       += w->lengths[idx];
+        w->pending[w->pending_tail++ % w->buffer_count] = idx;
+        uring_pump(w, 0);
+        return;
     }
-    str->length += length;
+#endif
+    sync_lock(w);
+    w->pending[w->pending_tail++ % w->buffer_count] = idx;
+    sync_signal(w, ready);
+    sync_unlock(w);
 }
 
-void string_write_u32(String* str, u32 val) {
-    u64 length = 0;
-    if (val == 0) {
-        str->buffer[str->length + length] = '0';
-        str->length += 1;
+void async_writer_write(AsyncWriter* w, const void* data, u64 length) {
+    const u8* src = data;
+    while (length > 0) {
+        if (w->current == ALL32) {
+            w->current              = async_writer_acquire(w);
+            w->lengths[w->current]  = 0;
+        }
+        u32 idx = w->current;
+        u64 n   = MIN(length, w->buffer_size - w->lengths[idx]);
+        memcpy(w->buffers[idx] + w->lengths[idx], src, n);
+        w->lengths[idx] += n;
+        src             += n;
+        length          -= n;
+        if (w->lengths[idx] == w->buffer_size) async_writer_submit(w);
     }
-    u32 aux_val = val;
-    while (aux_val != 0) {
-        aux_val /= 10;
-        length += 1;
+}
+
+void async_writer_print(AsyncWriter* w, const String str) { async_writer_write(w, str.buffer, str.length); }
+
+b8 async_writer_flush(AsyncWriter* w) {
+    if (w->current != ALL32 && w->lengths[w->current] > 0) async_writer_submit(w);
+    // An empty current buffer stays with the caller.
+    u32 idle = w->buffer_count - (w->current != ALL32);
+
+#if defined(SAMLIB_URING)
+    if (w->uring) {
+        while (w->free_count < idle) uring_pump(w, ALL32);
+        // Positional writes leave the descriptor where it was.
+        if (w->positional) lseek(w->fd, (off_t)w->offset, SEEK_SET);
+        return !w->failed;
     }
-    for (s32 i = length - 1; i >= 0; i--) {
-        str->buffer[str->length + i] = '0' + (val % 10);
-        val /= 10;
+#endif
+    sync_lock(w);
+    while (w->free_count < idle) sync_wait(w, drained);
+    b8 failed = w->failed;
+    sync_unlock(w);
+    return !failed;
+}
+
+b8 async_writer_close(AsyncWriter* w) {
+    b8 ok = async_writer_flush(w);
+#if defined(SAMLIB_URING)
+    if (w->uring) {
+        uring_teardown(w);
+        return ok;
     }
-    str->length += length;
+#endif
+    sync_lock(w);
+    w->stop = true;
+    sync_signal(w, ready);
+    sync_unlock(w);
+
+#if defined(__unix)
+    pthread_join(w->thread, NULL);
+    pthread_mutex_destroy(&w->lock);
+    pthread_cond_destroy(&w->ready);
+    pthread_cond_destroy(&w->drained);
+#else
+    WaitForSingleObject(w->thread, INFINITE);
+    CloseHandle(w->thread);
+    DeleteCriticalSection(&w->lock);
+#endif
+    return ok;
 }
 
-void string_write_u64(String* str, u64 val) {
-    u64 length = 0;
-    if (val == 0) {
-        str->buffer[str->length + length] = '0';
-        str->length += 1;
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                               FLOAT PARSING                               */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Correctly rounded decimal to binary conversion. Inputs with at most nineteen
+// significant digits go through Clinger's exact path or Eisel-Lemire (Lemire,
+// "Number Parsing at a Gigabyte per Second", 2021). The few cases those cannot
+// settle fall back to exact decimal shifting.
+
+#define POW5_SMALLEST_POWER -342
+#define POW5_LARGEST_POWER  308
+
+// 5^q for q in [-342, 308], truncated to 128 bits with the top bit set.
+local const u64 pow5_128[POW5_LARGEST_POWER - POW5_SMALLEST_POWER + 1][2] = {
+    { 1242899115359157055ull, 17218479456385750618ull },
+    { 5388497965526861063ull, 10761549660241094136ull },
+    { 6735622456908576329ull, 13451937075301367670ull },
+    { 17642900107990496220ull, 16814921344126709587ull },
+    { 8720969558280366185ull, 10509325840079193492ull },
+    { 10901211947850457732ull, 13136657300098991865ull },
+    { 18238200953240460069ull, 16420821625123739831ull },
+    { 18316404623416369399ull, 10263013515702337394ull },
+    { 13672133742415685941ull, 12828766894627921743ull },
+    { 12478481159592219522ull, 16035958618284902179ull },
+    { 5493207715531443249ull, 10022474136428063862ull },
+    { 16089881681269079869ull, 12528092670535079827ull },
+    { 15500666083158961933ull, 15660115838168849784ull },
+    { 9687916301974351208ull, 9787572398855531115ull },
+    { 7498209359040551106ull, 12234465498569413894ull },
+    { 149389661945913074ull, 15293081873211767368ull },
+    { 93368538716195671ull, 9558176170757354605ull },
+    { 4728396691822632493ull, 11947720213446693256ull },
+    { 5910495864778290617ull, 14934650266808366570ull },
+    { 8305745933913819539ull, 9334156416755229106ull },
+    { 1158810380537498616ull, 11667695520944036383ull },
+    { 15283571030954036982ull, 14584619401180045478ull },
+    { 9881091751837770420ull, 18230774251475056848ull },
+    { 6175682344898606512ull, 11394233907171910530ull },
+    { 16942974967978033949ull, 14242792383964888162ull },
+    { 11955346673117766628ull, 17803490479956110203ull },
+    { 5166248661484910190ull, 11127181549972568877ull },
+    { 11069496845283525642ull, 13908976937465711096ull },
+    { 13836871056604407053ull, 17386221171832138870ull },
+    { 4036358391950366504ull, 10866388232395086794ull },
+    { 14268820026792733938ull, 13582985290493858492ull },
+    { 17836025033490917422ull, 16978731613117323115ull },
+    { 8841672636718129437ull, 10611707258198326947ull },
+    { 6440404777470273892ull, 13264634072747908684ull },
+    { 8050505971837842365ull, 16580792590934885855ull },
+    { 11949095260039733334ull, 10362995369334303659ull },
+    { 10324683056622278764ull, 12953744211667879574ull },
+    { 3682481783923072647ull, 16192180264584849468ull },
+    { 11524923151806696212ull, 10120112665365530917ull },
+    { 571095884476206553ull, 12650140831706913647ull },
+    { 14548927910877421904ull, 15812676039633642058ull },
+    { 13704765962725776594ull, 9882922524771026286ull },
+    { 7907585416552444934ull, 12353653155963782858ull },
+    { 661109733835780360ull, 15442066444954728573ull },
+    { 2719036592861056677ull, 9651291528096705358ull },
+    { 12622167777931096654ull, 12064114410120881697ull },
+    { 1942651667131707105ull, 15080143012651102122ull },
+    { 5825843310384704845ull, 9425089382906938826ull },
+    { 16505676174835656864ull, 11781361728633673532ull },
+    { 2185351144835019464ull, 14726702160792091916ull },
+    { 2731688931043774330ull, 18408377700990114895ull },
+    { 8624834609543440812ull, 11505236063118821809ull },
+    { 15392729280356688919ull, 14381545078898527261ull },
+    { 5405853545163697437ull, 17976931348623159077ull },
+    { 5684501474941004850ull, 11235582092889474423ull },
+    { 2493940825248868159ull, 14044477616111843029ull },
+    { 7729112049988473103ull, 17555597020139803786ull },
+    { 9442381049670183593ull, 10972248137587377366ull },
+    { 2579604275232953683ull, 13715310171984221708ull },
+    { 3224505344041192104ull, 17144137714980277135ull },
+    { 8932844867666826921ull, 10715086071862673209ull },
+    { 15777742103010921555ull, 13393857589828341511ull },
+    { 15110491610336264040ull, 16742321987285426889ull },
+    { 2526528228819083169ull, 10463951242053391806ull },
+    { 12381532322878629770ull, 13079939052566739757ull },
+    { 1641857348316123500ull, 16349923815708424697ull },
+    { 12555375888766046947ull, 10218702384817765435ull },
+    { 11082533842530170780ull, 12773377981022206794ull },
+    { 4629795266307937667ull, 15966722476277758493ull },
+    { 5199465050656154994ull, 9979201547673599058ull },
+    { 15722703350174969551ull, 12474001934591998822ull },
+    { 10430007150863936130ull, 15592502418239998528ull },
+    { 6518754469289960081ull, 9745314011399999080ull },
+    { 8148443086612450102ull, 12181642514249998850ull },
+    { 962181821410786819ull, 15227053142812498563ull },
+    { 16742264702877599426ull, 9516908214257811601ull },
+    { 7092772823314835570ull, 11896135267822264502ull },
+    { 18089338065998320271ull, 14870169084777830627ull },
+    { 8999993282035256217ull, 9293855677986144142ull },
+    { 2026619565689294464ull, 11617319597482680178ull },
+    { 11756646493966393888ull, 14521649496853350222ull },
+    { 5472436080603216552ull, 18152061871066687778ull },
+    { 8031958568804398249ull, 11345038669416679861ull },
+    { 14651634229432885715ull, 14181298336770849826ull },
+    { 9091170749936331336ull, 17726622920963562283ull },
+    { 3376138709496513133ull, 11079139325602226427ull },
+    { 18055231442152805128ull, 13848924157002783033ull },
+    { 8733981247408842698ull, 17311155196253478792ull },
+    { 5458738279630526686ull, 10819471997658424245ull },
+    { 11435108867965546262ull, 13524339997073030306ull },
+    { 5070514048102157020ull, 16905424996341287883ull },
+    { 863228270850154185ull, 10565890622713304927ull },
+    { 14914093393844856443ull, 13207363278391631158ull },
+    { 9419244705451294746ull, 16509204097989538948ull },
+    { 15110399977761835024ull, 10318252561243461842ull },
+    { 9664627935347517973ull, 12897815701554327303ull },
+    { 7469098900757009562ull, 16122269626942909129ull },
+    { 16197401859041600736ull, 10076418516839318205ull },
+    { 6411694268519837208ull, 12595523146049147757ull },
+    { 12626303854077184414ull, 15744403932561434696ull },
+    { 7891439908798240259ull, 9840252457850896685ull },
+    { 14475985904425188227ull, 12300315572313620856ull },
+    { 18094982380531485284ull, 15375394465392026070ull },
+    { 6697677969404790399ull, 9609621540870016294ull },
+    { 17595469498610763806ull, 12012026926087520367ull },
+    { 17382650854836066854ull, 15015033657609400459ull },
+    { 8558313775058847832ull, 9384396036005875287ull },
+    { 6086206200396171886ull, 11730495045007344109ull },
+    { 12219443768922602761ull, 14663118806259180136ull },
+    { 15274304711153253452ull, 18328898507823975170ull },
+    { 14158126462898171311ull, 11455561567389984481ull },
+    { 3862600023340550427ull, 14319451959237480602ull },
+    { 14051622066030463842ull, 17899314949046850752ull },
+    { 8782263791269039901ull, 11187071843154281720ull },
+    { 10977829739086299876ull, 13983839803942852150ull },
+    { 4498915137003099037ull, 17479799754928565188ull },
+    { 12035193997481712706ull, 10924874846830353242ull },
+    { 5820620459997365075ull, 13656093558537941553ull },
+    { 11887461593424094248ull, 17070116948172426941ull },
+    { 9735506505103752857ull, 10668823092607766838ull },
+    { 2946011094524915263ull, 13336028865759708548ull },
+    { 3682513868156144079ull, 16670036082199635685ull },
+    { 4607414176811284001ull, 10418772551374772303ull },
+    { 1147581702586717097ull, 13023465689218465379ull },
+    { 15269535183515560084ull, 16279332111523081723ull },
+    { 7237616480483531100ull, 10174582569701926077ull },
+    { 13658706619031801779ull, 12718228212127407596ull },
+    { 17073383273789752224ull, 15897785265159259495ull },
+    { 17588393573759676996ull, 9936115790724537184ull },
+    { 3538747893490044629ull, 12420144738405671481ull },
+    { 9035120885289943691ull, 15525180923007089351ull },
+    { 12564479580947296663ull, 9703238076879430844ull },
+    { 15705599476184120828ull, 12129047596099288555ull },
+    { 15020313326802763131ull, 15161309495124110694ull },
+    { 4776009810824339053ull, 9475818434452569184ull },
+    { 5970012263530423816ull, 11844773043065711480ull },
+    { 7462515329413029771ull, 14805966303832139350ull },
+    { 52386062455755702ull, 9253728939895087094ull },
+    { 9288854614924470436ull, 11567161174868858867ull },
+    { 6999382250228200141ull, 14458951468586073584ull },
+    { 8749227812785250177ull, 18073689335732591980ull },
+    { 14691639419845557168ull, 11296055834832869987ull },
+    { 13752863256379558556ull, 14120069793541087484ull },
+    { 17191079070474448196ull, 17650087241926359355ull },
+    { 8438581409832836170ull, 11031304526203974597ull },
+    { 15159912780718433117ull, 13789130657754968246ull },
+    { 9726518939043265588ull, 17236413322193710308ull },
+    { 15302446373756816800ull, 10772758326371068942ull },
+    { 9904685930341245193ull, 13465947907963836178ull },
+    { 3157485376071780683ull, 16832434884954795223ull },
+    { 8890957387685944783ull, 10520271803096747014ull },
+    { 1890324697752655170ull, 13150339753870933768ull },
+    { 2362905872190818963ull, 16437924692338667210ull },
+    { 6088502188546649756ull, 10273702932711667006ull },
+    { 16833999772538088003ull, 12842128665889583757ull },
+    { 7207441660390446292ull, 16052660832361979697ull },
+    { 16033866083812498692ull, 10032913020226237310ull },
+    { 10818960567910847557ull, 12541141275282796638ull },
+    { 4300328673033783639ull, 15676426594103495798ull },
+    { 16522763475928278486ull, 9797766621314684873ull },
+    { 6818396289628184396ull, 12247208276643356092ull },
+    { 8522995362035230495ull, 15309010345804195115ull },
+    { 3021029092058325107ull, 9568131466127621947ull },
+    { 17611344420355070096ull, 11960164332659527433ull },
+    { 8179122470161673908ull, 14950205415824409292ull },
+    { 14335323580705822000ull, 9343878384890255807ull },
+    { 13307468457454889596ull, 11679847981112819759ull },
+    { 12022649553391224092ull, 14599809976391024699ull },
+    { 10416625923311642211ull, 18249762470488780874ull },
+    { 11122077220497164286ull, 11406101544055488046ull },
+    { 4679224488766679549ull, 14257626930069360058ull },
+    { 15072402647813125244ull, 17822033662586700072ull },
+    { 9420251654883203278ull, 11138771039116687545ull },
+    { 16387000587031392001ull, 13923463798895859431ull },
+    { 15872064715361852097ull, 17404329748619824289ull },
+    { 3002511419460075705ull, 10877706092887390181ull },
+    { 8364825292752482535ull, 13597132616109237726ull },
+    { 1232659579085827361ull, 16996415770136547158ull },
+    { 14605470292210805812ull, 10622759856335341973ull },
+    { 4421779809981343554ull, 13278449820419177467ull },
+    { 915538744049291538ull, 16598062275523971834ull },
+    { 5183897733458195115ull, 10373788922202482396ull },
+    { 6479872166822743894ull, 12967236152753102995ull },
+    { 3488154190101041964ull, 16209045190941378744ull },
+    { 2180096368813151227ull, 10130653244338361715ull },
+    { 16560178516298602746ull, 12663316555422952143ull },
+    { 16088537126945865529ull, 15829145694278690179ull },
+    { 7749492695127472003ull, 9893216058924181362ull },
+    { 463493832054564196ull, 12366520073655226703ull },
+    { 14414425345350368957ull, 15458150092069033378ull },
+    { 13620701859271368502ull, 9661343807543145861ull },
+    { 3190819268807046916ull, 12076679759428932327ull },
+    { 17823582141290972357ull, 15095849699286165408ull },
+    { 11139738838306857723ull, 9434906062053853380ull },
+    { 13924673547883572154ull, 11793632577567316725ull },
+    { 3570783879572301480ull, 14742040721959145907ull },
+    { 18298537904747540562ull, 18427550902448932383ull },
+    { 18354115218108294707ull, 11517219314030582739ull },
+    { 18330958004207980480ull, 14396524142538228424ull },
+    { 4466953431550423984ull, 17995655178172785531ull },
+    { 486002885505321038ull, 11247284486357990957ull },
+    { 5219189625309039202ull, 14059105607947488696ull },
+    { 6523987031636299002ull, 17573882009934360870ull },
+    { 17912549950054850588ull, 10983676256208975543ull },
+    { 17779001419141175331ull, 13729595320261219429ull },
+    { 8388693718644305452ull, 17161994150326524287ull },
+    { 12160462601793772764ull, 10726246343954077679ull },
+    { 10588892233814828051ull, 13407807929942597099ull },
+    { 8624429273841147159ull, 16759759912428246374ull },
+    { 778582277723329070ull, 10474849945267653984ull },
+    { 973227847154161338ull, 13093562431584567480ull },
+    { 1216534808942701673ull, 16366953039480709350ull },
+    { 14595392310871352257ull, 10229345649675443343ull },
+    { 13632554370161802418ull, 12786682062094304179ull },
+    { 12429006944274865118ull, 15983352577617880224ull },
+    { 7768129340171790699ull, 9989595361011175140ull },
+    { 9710161675214738374ull, 12486994201263968925ull },
+    { 16749388112445810871ull, 15608742751579961156ull },
+    { 1244995533423855986ull, 9755464219737475723ull },
+    { 15391302472061983695ull, 12194330274671844653ull },
+    { 5404070034795315907ull, 15242912843339805817ull },
+    { 14906758817815542202ull, 9526820527087378635ull },
+    { 14021762503842039848ull, 11908525658859223294ull },
+    { 8303831092947774002ull, 14885657073574029118ull },
+    { 578208414664970847ull, 9303535670983768199ull },
+    { 14557818573613377271ull, 11629419588729710248ull },
+    { 18197273217016721589ull, 14536774485912137810ull },
+    { 13523219484416126178ull, 18170968107390172263ull },
+    { 15369541205401160717ull, 11356855067118857664ull },
+    { 765182433041899281ull, 14196068833898572081ull },
+    { 5568164059729762005ull, 17745086042373215101ull },
+    { 5785945546544795205ull, 11090678776483259438ull },
+    { 16455803970035769814ull, 13863348470604074297ull },
+    { 6734696907262548556ull, 17329185588255092872ull },
+    { 4209185567039092847ull, 10830740992659433045ull },
+    { 9873167977226253963ull, 13538426240824291306ull },
+    { 3118087934678041646ull, 16923032801030364133ull },
+    { 4254647968387469981ull, 10576895500643977583ull },
+    { 706623942056949572ull, 13221119375804971979ull },
+    { 14718337982853350677ull, 16526399219756214973ull },
+    { 11504804248497038125ull, 10328999512347634358ull },
+    { 5157633273766521849ull, 12911249390434542948ull },
+    { 6447041592208152311ull, 16139061738043178685ull },
+    { 6335244004343789146ull, 10086913586276986678ull },
+    { 17142427042284512241ull, 12608641982846233347ull },
+    { 16816347784428252397ull, 15760802478557791684ull },
+    { 1286845328412881940ull, 9850501549098619803ull },
+    { 15443614715798266137ull, 12313126936373274753ull },
+    { 5469460339465668959ull, 15391408670466593442ull },
+    { 8030098730593431003ull, 9619630419041620901ull },
+    { 14649309431669176658ull, 12024538023802026126ull },
+    { 9088264752731695015ull, 15030672529752532658ull },
+    { 10291851488884697288ull, 9394170331095332911ull },
+    { 8253128342678483706ull, 11742712913869166139ull },
+    { 5704724409920716729ull, 14678391142336457674ull },
+    { 16354277549255671720ull, 18347988927920572092ull },
+    { 998051431430019017ull, 11467493079950357558ull },
+    { 10470936326142299579ull, 14334366349937946947ull },
+    { 8476984389250486570ull, 17917957937422433684ull },
+    { 14521487280136329914ull, 11198723710889021052ull },
+    { 18151859100170412392ull, 13998404638611276315ull },
+    { 18078137856785627587ull, 17498005798264095394ull },
+    { 15910522178918405146ull, 10936253623915059621ull },
+    { 6053094668365842720ull, 13670317029893824527ull },
+    { 2954682317029915496ull, 17087896287367280659ull },
+    { 17987577512639554849ull, 10679935179604550411ull },
+    { 17872785872372055657ull, 13349918974505688014ull },
+    { 13117610303610293764ull, 16687398718132110018ull },
+    { 12810192458183821506ull, 10429624198832568761ull },
+    { 2177682517447613171ull, 13037030248540710952ull },
+    { 2722103146809516464ull, 16296287810675888690ull },
+    { 6313000485183335694ull, 10185179881672430431ull },
+    { 3279564588051781713ull, 12731474852090538039ull },
+    { 17934513790346890853ull, 15914343565113172548ull },
+    { 1985699082112030975ull, 9946464728195732843ull },
+    { 16317181907922202431ull, 12433080910244666053ull },
+    { 6561419329620589327ull, 15541351137805832567ull },
+    { 11018416108653950185ull, 9713344461128645354ull },
+    { 4549648098962661924ull, 12141680576410806693ull },
+    { 10298746142130715309ull, 15177100720513508366ull },
+    { 1825030320404309164ull, 9485687950320942729ull },
+    { 6892973918932774359ull, 11857109937901178411ull },
+    { 4004531380238580045ull, 14821387422376473014ull },
+    { 16337890167931276240ull, 9263367138985295633ull },
+    { 6587304654631931588ull, 11579208923731619542ull },
+    { 17457502855144690293ull, 14474011154664524427ull },
+    { 17210192550503474962ull, 18092513943330655534ull },
+    { 6144684325637283947ull, 11307821214581659709ull },
+    { 12292541425473992838ull, 14134776518227074636ull },
+    { 15365676781842491048ull, 17668470647783843295ull },
+    { 16521077016292638761ull, 11042794154864902059ull },
+    { 16039660251938410547ull, 13803492693581127574ull },
+    { 10826203278068237376ull, 17254365866976409468ull },
+    { 15989749085647424168ull, 10783978666860255917ull },
+    { 6152128301777116498ull, 13479973333575319897ull },
+    { 12301846395648783526ull, 16849966666969149871ull },
+    { 14606183024921571560ull, 10531229166855718669ull },
+    { 4422670725869800738ull, 13164036458569648337ull },
+    { 10140024425764638826ull, 16455045573212060421ull },
+    { 8643358275316593218ull, 10284403483257537763ull },
+    { 6192511825718353619ull, 12855504354071922204ull },
+    { 7740639782147942024ull, 16069380442589902755ull },
+    { 2532056854628769813ull, 10043362776618689222ull },
+    { 12388443105140738074ull, 12554203470773361527ull },
+    { 10873867862998534689ull, 15692754338466701909ull },
+    { 9102010423587778132ull, 9807971461541688693ull },
+    { 15989199047912110569ull, 12259964326927110866ull },
+    { 10763126773035362404ull, 15324955408658888583ull },
+    { 13644483260788183358ull, 9578097130411805364ull },
+    { 17055604075985229198ull, 11972621413014756705ull },
+    { 7484447039699372786ull, 14965776766268445882ull },
+    { 9289465418239495895ull, 9353610478917778676ull },
+    { 11611831772799369869ull, 11692013098647223345ull },
+    { 679731660717048624ull, 14615016373309029182ull },
+    { 10073036612751086588ull, 18268770466636286477ull },
+    { 8601490892183123070ull, 11417981541647679048ull },
+    { 10751863615228903838ull, 14272476927059598810ull },
+    { 4216457482181353989ull, 17840596158824498513ull },
+    { 14164500972431816003ull, 11150372599265311570ull },
+    { 8482254178684994196ull, 13937965749081639463ull },
+    { 5991131704928854841ull, 17422457186352049329ull },
+    { 15273672361649004036ull, 10889035741470030830ull },
+    { 9868718415206479237ull, 13611294676837538538ull },
+    { 3112525982153323238ull, 17014118346046923173ull },
+    { 4251171748059520976ull, 10633823966279326983ull },
+    { 702278666647013315ull, 13292279957849158729ull },
+    { 5489534351736154548ull, 16615349947311448411ull },
+    { 1125115960621402641ull, 10384593717069655257ull },
+    { 6018080969204141205ull, 12980742146337069071ull },
+    { 2910915193077788602ull, 16225927682921336339ull },
+    { 17960223060169475540ull, 10141204801825835211ull },
+    { 17838592806784456521ull, 12676506002282294014ull },
+    { 13074868971625794844ull, 15845632502852867518ull },
+    { 3560107088838733873ull, 9903520314283042199ull },
+    { 18285191916330581054ull, 12379400392853802748ull },
+    { 4409745821703674701ull, 15474250491067253436ull },
+    { 11979463175419572496ull, 9671406556917033397ull },
+    { 1139270913992301908ull, 12089258196146291747ull },
+    { 15259146697772541097ull, 15111572745182864683ull },
+    { 7231123676894144234ull, 9444732965739290427ull },
+    { 4427218577690292388ull, 11805916207174113034ull },
+    { 14757395258967641293ull, 14757395258967641292ull },
+    { 0ull, 9223372036854775808ull },
+    { 0ull, 11529215046068469760ull },
+    { 0ull, 14411518807585587200ull },
+    { 0ull, 18014398509481984000ull },
+    { 0ull, 11258999068426240000ull },
+    { 0ull, 14073748835532800000ull },
+    { 0ull, 17592186044416000000ull },
+    { 0ull, 10995116277760000000ull },
+    { 0ull, 13743895347200000000ull },
+    { 0ull, 17179869184000000000ull },
+    { 0ull, 10737418240000000000ull },
+    { 0ull, 13421772800000000000ull },
+    { 0ull, 16777216000000000000ull },
+    { 0ull, 10485760000000000000ull },
+    { 0ull, 13107200000000000000ull },
+    { 0ull, 16384000000000000000ull },
+    { 0ull, 10240000000000000000ull },
+    { 0ull, 12800000000000000000ull },
+    { 0ull, 16000000000000000000ull },
+    { 0ull, 10000000000000000000ull },
+    { 0ull, 12500000000000000000ull },
+    { 0ull, 15625000000000000000ull },
+    { 0ull, 9765625000000000000ull },
+    { 0ull, 12207031250000000000ull },
+    { 0ull, 15258789062500000000ull },
+    { 0ull, 9536743164062500000ull },
+    { 0ull, 11920928955078125000ull },
+    { 0ull, 14901161193847656250ull },
+    { 4611686018427387904ull, 9313225746154785156ull },
+    { 5764607523034234880ull, 11641532182693481445ull },
+    { 11817445422220181504ull, 14551915228366851806ull },
+    { 5548434740920451072ull, 18189894035458564758ull },
+    { 17302829768357445632ull, 11368683772161602973ull },
+    { 7793479155164643328ull, 14210854715202003717ull },
+    { 14353534962383192064ull, 17763568394002504646ull },
+    { 4359273333062107136ull, 11102230246251565404ull },
+    { 5449091666327633920ull, 13877787807814456755ull },
+    { 2199678564482154496ull, 17347234759768070944ull },
+    { 1374799102801346560ull, 10842021724855044340ull },
+    { 1718498878501683200ull, 13552527156068805425ull },
+    { 6759809616554491904ull, 16940658945086006781ull },
+    { 6530724019560251392ull, 10587911840678754238ull },
+    { 17386777061305090048ull, 13234889800848442797ull },
+    { 7898413271349198848ull, 16543612251060553497ull },
+    { 16465723340661719040ull, 10339757656912845935ull },
+    { 15970468157399760896ull, 12924697071141057419ull },
+    { 15351399178322313216ull, 16155871338926321774ull },
+    { 4982938468024057856ull, 10097419586828951109ull },
+    { 10840359103457460224ull, 12621774483536188886ull },
+    { 4327076842467049472ull, 15777218104420236108ull },
+    { 11927795063396681728ull, 9860761315262647567ull },
+    { 10298057810818464256ull, 12325951644078309459ull },
+    { 8260886245095692416ull, 15407439555097886824ull },
+    { 5163053903184807760ull, 9629649721936179265ull },
+    { 11065503397408397604ull, 12037062152420224081ull },
+    { 18443565265187884909ull, 15046327690525280101ull },
+    { 13833071299956122020ull, 9403954806578300063ull },
+    { 12679653106517764621ull, 11754943508222875079ull },
+    { 11237880364719817872ull, 14693679385278593849ull },
+    { 212292400617608628ull, 18367099231598242312ull },
+    { 132682750386005392ull, 11479437019748901445ull },
+    { 4777539456409894645ull, 14349296274686126806ull },
+    { 15195296357367144114ull, 17936620343357658507ull },
+    { 7191217214140771119ull, 11210387714598536567ull },
+    { 4377335499248575995ull, 14012984643248170709ull },
+    { 10083355392488107898ull, 17516230804060213386ull },
+    { 10913783138732455340ull, 10947644252537633366ull },
+    { 4418856886560793367ull, 13684555315672041708ull },
+    { 5523571108200991709ull, 17105694144590052135ull },
+    { 10369760970266701674ull, 10691058840368782584ull },
+    { 12962201212833377092ull, 13363823550460978230ull },
+    { 6979379479186945558ull, 16704779438076222788ull },
+    { 13585484211346616781ull, 10440487148797639242ull },
+    { 7758483227328495169ull, 13050608935997049053ull },
+    { 14309790052588006865ull, 16313261169996311316ull },
+    { 18166990819722280098ull, 10195788231247694572ull },
+    { 4261994450943298507ull, 12744735289059618216ull },
+    { 5327493063679123134ull, 15930919111324522770ull },
+    { 7941369183226839863ull, 9956824444577826731ull },
+    { 5315025460606161924ull, 12446030555722283414ull },
+    { 15867153862612478214ull, 15557538194652854267ull },
+    { 7611128154919104931ull, 9723461371658033917ull },
+    { 14125596212076269068ull, 12154326714572542396ull },
+    { 17656995265095336336ull, 15192908393215677995ull },
+    { 8729779031470891258ull, 9495567745759798747ull },
+    { 6300537770911226168ull, 11869459682199748434ull },
+    { 17099044250493808518ull, 14836824602749685542ull },
+    { 6075216638131242420ull, 9273015376718553464ull },
+    { 7594020797664053025ull, 11591269220898191830ull },
+    { 269153960225290473ull, 14489086526122739788ull },
+    { 336442450281613091ull, 18111358157653424735ull },
+    { 7127805559067090038ull, 11319598848533390459ull },
+    { 4298070930406474644ull, 14149498560666738074ull },
+    { 14595960699862869113ull, 17686873200833422592ull },
+    { 9122475437414293195ull, 11054295750520889120ull },
+    { 11403094296767866494ull, 13817869688151111400ull },
+    { 14253867870959833118ull, 17272337110188889250ull },
+    { 13520353437777283602ull, 10795210693868055781ull },
+    { 3065383741939440791ull, 13494013367335069727ull },
+    { 17666787732706464701ull, 16867516709168837158ull },
+    { 6430056314514152534ull, 10542197943230523224ull },
+    { 8037570393142690668ull, 13177747429038154030ull },
+    { 823590954573587527ull, 16472184286297692538ull },
+    { 5126430365035880108ull, 10295115178936057836ull },
+    { 6408037956294850135ull, 12868893973670072295ull },
+    { 3398361426941174765ull, 16086117467087590369ull },
+    { 13653190937906703988ull, 10053823416929743980ull },
+    { 17066488672383379985ull, 12567279271162179975ull },
+    { 16721424822051837077ull, 15709099088952724969ull },
+    { 3533361486141316317ull, 9818186930595453106ull },
+    { 13640073894531421205ull, 12272733663244316382ull },
+    { 7826720331309500698ull, 15340917079055395478ull },
+    { 280014188641050032ull, 9588073174409622174ull },
+    { 9573389772656088348ull, 11985091468012027717ull },
+    { 16578423234247498339ull, 14981364335015034646ull },
+    { 5749828502977298558ull, 9363352709384396654ull },
+    { 16410657665576399005ull, 11704190886730495817ull },
+    { 6678264026688335045ull, 14630238608413119772ull },
+    { 8347830033360418806ull, 18287798260516399715ull },
+    { 2911550761636567802ull, 11429873912822749822ull },
+    { 12862810488900485560ull, 14287342391028437277ull },
+    { 2243455055843443238ull, 17859177988785546597ull },
+    { 3708002419115845976ull, 11161986242990966623ull },
+    { 23317005467419566ull, 13952482803738708279ull },
+    { 13864204312116438170ull, 17440603504673385348ull },
+    { 17888499731927549664ull, 10900377190420865842ull },
+    { 13137252628054661272ull, 13625471488026082303ull },
+    { 11809879766640938686ull, 17031839360032602879ull },
+    { 14298703881791668535ull, 10644899600020376799ull },
+    { 13261693833812197764ull, 13306124500025470999ull },
+    { 11965431273837859301ull, 16632655625031838749ull },
+    { 9784237555362356015ull, 10395409765644899218ull },
+    { 3006924907348169211ull, 12994262207056124023ull },
+    { 17593714189467375226ull, 16242827758820155028ull },
+    { 1772699331562333708ull, 10151767349262596893ull },
+    { 6827560182880305039ull, 12689709186578246116ull },
+    { 8534450228600381299ull, 15862136483222807645ull },
+    { 7639874402088932264ull, 9913835302014254778ull },
+    { 326470965756389522ull, 12392294127517818473ull },
+    { 5019774725622874806ull, 15490367659397273091ull },
+    { 831516194300602802ull, 9681479787123295682ull },
+    { 10262767279730529310ull, 12101849733904119602ull },
+    { 3605087062808385830ull, 15127312167380149503ull },
+    { 9170708441896323000ull, 9454570104612593439ull },
+    { 6851699533943015846ull, 11818212630765741799ull },
+    { 3952938399001381903ull, 14772765788457177249ull },
+    { 13999801545444333449ull, 9232978617785735780ull },
+    { 17499751931805416812ull, 11541223272232169725ull },
+    { 8039631859474607303ull, 14426529090290212157ull },
+    { 14661225842770647033ull, 18033161362862765196ull },
+    { 18386638188586430203ull, 11270725851789228247ull },
+    { 18371611717305649850ull, 14088407314736535309ull },
+    { 9129456591349898601ull, 17610509143420669137ull },
+    { 17235125415662156385ull, 11006568214637918210ull },
+    { 12320534732722919674ull, 13758210268297397763ull },
+    { 10788982397476261688ull, 17197762835371747204ull },
+    { 15966486035277439363ull, 10748601772107342002ull },
+    { 10734735507242023396ull, 13435752215134177503ull },
+    { 8806733365625141341ull, 16794690268917721879ull },
+    { 12421737381156795194ull, 10496681418073576174ull },
+    { 6303799689591218185ull, 13120851772591970218ull },
+    { 17103121648843798539ull, 16401064715739962772ull },
+    { 1466078993672598279ull, 10250665447337476733ull },
+    { 6444284760518135752ull, 12813331809171845916ull },
+    { 8055355950647669691ull, 16016664761464807395ull },
+    { 2728754459941099604ull, 10010415475915504622ull },
+    { 12634315111781150314ull, 12513019344894380777ull },
+    { 1957835834444274180ull, 15641274181117975972ull },
+    { 10447019433382447170ull, 9775796363198734982ull },
+    { 3835402254873283155ull, 12219745453998418728ull },
+    { 4794252818591603944ull, 15274681817498023410ull },
+    { 7608094030047140369ull, 9546676135936264631ull },
+    { 4898431519131537557ull, 11933345169920330789ull },
+    { 10734725417341809851ull, 14916681462400413486ull },
+    { 2097517367411243253ull, 9322925914000258429ull },
+    { 7233582727691441970ull, 11653657392500323036ull },
+    { 9041978409614302462ull, 14567071740625403795ull },
+    { 6690786993590490174ull, 18208839675781754744ull },
+    { 4181741870994056359ull, 11380524797363596715ull },
+    { 615491320315182544ull, 14225655996704495894ull },
+    { 9992736187248753989ull, 17782069995880619867ull },
+    { 3939617107816777291ull, 11113793747425387417ull },
+    { 9536207403198359517ull, 13892242184281734271ull },
+    { 7308573235570561493ull, 17365302730352167839ull },
+    { 11485387299872682789ull, 10853314206470104899ull },
+    { 9745048106413465582ull, 13566642758087631124ull },
+    { 12181310133016831978ull, 16958303447609538905ull },
+    { 695789805494438130ull, 10598939654755961816ull },
+    { 869737256868047663ull, 13248674568444952270ull },
+    { 10310543607939835386ull, 16560843210556190337ull },
+    { 17973304801030866876ull, 10350527006597618960ull },
+    { 4019886927579031980ull, 12938158758247023701ull },
+    { 9636544677901177879ull, 16172698447808779626ull },
+    { 10634526442115624078ull, 10107936529880487266ull },
+    { 4069786015789754290ull, 12634920662350609083ull },
+    { 475546501309804958ull, 15793650827938261354ull },
+    { 4908902581746016003ull, 9871031767461413346ull },
+    { 15359500264037295811ull, 12338789709326766682ull },
+    { 9976003293191843956ull, 15423487136658458353ull },
+    { 17764217104313372233ull, 9639679460411536470ull },
+    { 12981899343536939483ull, 12049599325514420588ull },
+    { 16227374179421174354ull, 15061999156893025735ull },
+    { 17059637889779315827ull, 9413749473058141084ull },
+    { 2877803288514593168ull, 11767186841322676356ull },
+    { 3597254110643241460ull, 14708983551653345445ull },
+    { 9108253656731439729ull, 18386229439566681806ull },
+    { 1080972517029761926ull, 11491393399729176129ull },
+    { 5962901664714590312ull, 14364241749661470161ull },
+    { 12065313099320625794ull, 17955302187076837701ull },
+    { 9846663696289085073ull, 11222063866923023563ull },
+    { 7696643601933968437ull, 14027579833653779454ull },
+    { 397432465562684739ull, 17534474792067224318ull },
+    { 14083453346258841674ull, 10959046745042015198ull },
+    { 8380944645968776284ull, 13698808431302518998ull },
+    { 1252808770606194547ull, 17123510539128148748ull },
+    { 10006377518483647400ull, 10702194086955092967ull },
+    { 7896285879677171346ull, 13377742608693866209ull },
+    { 14482043368023852087ull, 16722178260867332761ull },
+    { 2133748077373825698ull, 10451361413042082976ull },
+    { 2667185096717282123ull, 13064201766302603720ull },
+    { 3333981370896602653ull, 16330252207878254650ull },
+    { 6695424375237764562ull, 10206407629923909156ull },
+    { 8369280469047205703ull, 12758009537404886445ull },
+    { 15073286604736395033ull, 15947511921756108056ull },
+    { 9420804127960246895ull, 9967194951097567535ull },
+    { 7164319141522920715ull, 12458993688871959419ull },
+    { 4343712908476262990ull, 15573742111089949274ull },
+    { 7326506586225052273ull, 9733588819431218296ull },
+    { 9158133232781315341ull, 12166986024289022870ull },
+    { 2224294504121868368ull, 15208732530361278588ull },
+    { 10613556101930943538ull, 9505457831475799117ull },
+    { 17878631145841067327ull, 11881822289344748896ull },
+    { 3901544858591782542ull, 14852277861680936121ull },
+    { 13967680582688333849ull, 9282673663550585075ull },
+    { 12847914709933029407ull, 11603342079438231344ull },
+    { 16059893387416286759ull, 14504177599297789180ull },
+    { 1628122660560806833ull, 18130221999122236476ull },
+    { 10240948699705280078ull, 11331388749451397797ull },
+    { 17412871893058988002ull, 14164235936814247246ull },
+    { 12542717829468959195ull, 17705294921017809058ull },
+    { 12450884661845487401ull, 11065809325636130661ull },
+    { 1728547772024695539ull, 13832261657045163327ull },
+    { 15995742770313033136ull, 17290327071306454158ull },
+    { 5385653213018257806ull, 10806454419566533849ull },
+    { 11343752534700210161ull, 13508068024458167311ull },
+    { 9568004649947874797ull, 16885085030572709139ull },
+    { 3674159897003727796ull, 10553178144107943212ull },
+    { 4592699871254659745ull, 13191472680134929015ull },
+    { 1129188820640936778ull, 16489340850168661269ull },
+    { 3011586022114279438ull, 10305838031355413293ull },
+    { 8376168546070237202ull, 12882297539194266616ull },
+    { 10470210682587796502ull, 16102871923992833270ull },
+    { 1932195658189984910ull, 10064294952495520794ull },
+    { 11638616609592256945ull, 12580368690619400992ull },
+    { 14548270761990321182ull, 15725460863274251240ull },
+    { 9092669226243950738ull, 9828413039546407025ull },
+    { 15977522551232326327ull, 12285516299433008781ull },
+    { 6136845133758244197ull, 15356895374291260977ull },
+    { 15364743254667372383ull, 9598059608932038110ull },
+    { 9982557031479439671ull, 11997574511165047638ull },
+    { 3254824252494523781ull, 14996968138956309548ull },
+    { 11257637194663853171ull, 9373105086847693467ull },
+    { 9460360474902428559ull, 11716381358559616834ull },
+    { 2602078556773259891ull, 14645476698199521043ull },
+    { 17087656251248738576ull, 18306845872749401303ull },
+    { 17597314184671543466ull, 11441778670468375814ull },
+    { 12773270693984653525ull, 14302223338085469768ull },
+    { 15966588367480816906ull, 17877779172606837210ull },
+    { 14590803748102898470ull, 11173611982879273256ull },
+    { 18238504685128623088ull, 13967014978599091570ull },
+    { 13574758819556003052ull, 17458768723248864463ull },
+    { 15401753289863583763ull, 10911730452030540289ull },
+    { 5417133557047315992ull, 13639663065038175362ull },
+    { 15994788983163920798ull, 17049578831297719202ull },
+    { 14608429132904838403ull, 10655986769561074501ull },
+    { 4425478360848884291ull, 13319983461951343127ull },
+    { 920161932633717460ull, 16649979327439178909ull },
+    { 2880944217109767365ull, 10406237079649486818ull },
+    { 12824552308241985014ull, 13007796349561858522ull },
+    { 6807318348447705459ull, 16259745436952323153ull },
+    { 15783789013848285672ull, 10162340898095201970ull },
+    { 10506364230455581282ull, 12702926122619002463ull },
+    { 8521269269642088699ull, 15878657653273753079ull },
+    { 12243322321167387293ull, 9924161033296095674ull },
+    { 6080780864604458308ull, 12405201291620119593ull },
+    { 12212662099182960789ull, 15506501614525149491ull },
+    { 5327070802775656541ull, 9691563509078218432ull },
+    { 6658838503469570676ull, 12114454386347773040ull },
+    { 8323548129336963345ull, 15143067982934716300ull },
+    { 14425589617690377899ull, 9464417489334197687ull },
+    { 13420301003685584469ull, 11830521861667747109ull },
+    { 2940318199324816875ull, 14788152327084683887ull },
+    { 8755227902219092403ull, 9242595204427927429ull },
+    { 15555720896201253407ull, 11553244005534909286ull },
+    { 10221279083396790951ull, 14441555006918636608ull },
+    { 12776598854245988689ull, 18051943758648295760ull },
+    { 7985374283903742931ull, 11282464849155184850ull },
+    { 758345818024902856ull, 14103081061443981063ull },
+    { 14782990327813292282ull, 17628851326804976328ull },
+    { 9239368954883307676ull, 11018032079253110205ull },
+    { 16160897212031522499ull, 13772540099066387756ull },
+    { 1754377441329851508ull, 17215675123832984696ull },
+    { 1096485900831157192ull, 10759796952395615435ull },
+    { 15205665431321110202ull, 13449746190494519293ull },
+    { 5172023733869224041ull, 16812182738118149117ull },
+    { 5538357842881958977ull, 10507614211323843198ull },
+    { 16146319340457224530ull, 13134517764154803997ull },
+    { 6347841120289366950ull, 16418147205193504997ull },
+    { 6273243709394548296ull, 10261342003245940623ull },
+};
+
+local const f64 exact_pow10_f64[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+local const f32 exact_pow10_f32[] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f,
+};
+
+typedef struct {
+    s32 mantissa_bits;     // Explicit mantissa bits.
+    s32 min_exponent;      // Negated exponent bias.
+    s32 infinite_power;    // Biased exponent of infinity.
+    s32 sign_index;
+    s32 min_round_to_even; // Powers of ten where exact halfway products occur.
+    s32 max_round_to_even;
+    s32 smallest_power;    // Anything below rounds to zero.
+    s32 largest_power;     // Anything above is infinite.
+    s32 max_exact_power;   // Largest power of ten the type holds exactly.
+    u64 max_exact_mantissa;
+} FloatFormat;
+
+local const FloatFormat f64_format = { 52, -1023, 0x7FF, 63, -4, 23, -342, 308, 22, 1ull << 53 };
+local const FloatFormat f32_format = { 23, -127, 0xFF, 31, -17, 10, -65, 38, 10, 1ull << 24 };
+
+typedef struct {
+    u64 mantissa;
+    s32 power2; // Biased exponent, -1 when Eisel-Lemire cannot decide.
+} BinaryFloat;
+
+local BinaryFloat eisel_lemire(const FloatFormat* fmt, s64 q, u64 w) {
+    BinaryFloat answer = { 0, 0 };
+    if (w == 0 || q < fmt->smallest_power) return answer;
+    if (q > fmt->largest_power) {
+        answer.power2 = fmt->infinite_power;
+        return answer;
     }
-    u64 aux_val = val;
-    while (aux_val != 0) {
-        aux_val /= 10;
-        length += 1;
+
+    u32 lz  = 63 - msb_index(w);
+    w     <<= lz;
+
+    // Only the bits that decide rounding need the second half of 5^q.
+    const u64* pow5 = pow5_128[q - POW5_SMALLEST_POWER];
+    u64 high;
+    u64 low  = umul128(w, pow5[1], &high);
+    u64 mask = ALL64 >> (fmt->mantissa_bits + 3);
+    if ((high & mask) == mask) {
+        u64 second_high;
+        umul128(w, pow5[0], &second_high);
+        low += second_high;
+        if (second_high > low) high++;
     }
-    for (s32 i = length - 1; i >= 0; i--) {
-        str->buffer[str->length + i] = '0' + (val % 10);
-        val /= 10;
+    if (low == ALL64 && (q < -27 || q > 55)) {
+        answer.power2 = -1;
+        return answer;
     }
-    str->length += length;
-}
 
-void string_write_f32(String* str, f32 val) {
-    u64 length = 0;
-    s32 whole = (s32)val;
-    val -= whole;
-    b8 neg = (whole < 0);
-    if (neg) {
-        str->buffer[str->length] = '-';
-        str->length += 1;
-        whole = -whole;
-    }
-    if (whole == 0) {
-        str->buffer[str->length] = '0';
-        str->length += 1;
+    s32 upper_bit   = (s32)(high >> 63);
+    s32 shift       = upper_bit + 64 - fmt->mantissa_bits - 3;
+    answer.mantissa = high >> shift;
+    answer.power2   = (s32)((((152170 + 65536) * q) >> 16) + 63) + upper_bit - (s32)lz - fmt->min_exponent;
+
+    if (answer.power2 <= 0) {
+        // Subnormal, or zero when every bit shifts out.
+        if (-answer.power2 + 1 >= 64) {
+            answer.mantissa = 0;
+            answer.power2   = 0;
+            return answer;
+        }
+        answer.mantissa >>= -answer.power2 + 1;
+        answer.mantissa  += answer.mantissa & 1;
+        answer.mantissa >>= 1;
+        answer.power2     = answer.mantissa < (1ull << fmt->mantissa_bits) ? 0 : 1;
+        return answer;
     }
-    s32 whole_aux = whole;
-    while (whole_aux != 0) {
-        whole_aux /= 10;
-        length += 1;
+
+    // An exact halfway product rounds to even rather than up.
+    if (low <= 1 && q >= fmt->min_round_to_even && q <= fmt->max_round_to_even &&
+        (answer.mantissa & 3) == 1 && (answer.mantissa << shift) == high) {
+        answer.mantissa &= ~1ull;
     }
-    for (s32 i = length - 1; i >= 0; i--) {
-        str->buffer[str->length + i] = '0' + (whole % 10);
-        whole /= 10;
+    answer.mantissa  += answer.mantissa & 1;
+    answer.mantissa >>= 1;
+    if (answer.mantissa >= (2ull << fmt->mantissa_bits)) {
+        answer.mantissa = 1ull << fmt->mantissa_bits;
+        answer.power2++;
     }
-    str->length += length;
-    str->buffer[str->length] = '.';
-    str->length += 1;
-    for (s8 prec = 0; prec < 12; prec++) {
-        val *= 10;
-        s32 digit = (s32)val;
-        str->buffer[str->length] = '0' + digit;
-        str->length += 1;
-        val -= digit;
+    answer.mantissa &= ~(1ull << fmt->mantissa_bits);
+    if (answer.power2 >= fmt->infinite_power) {
+        answer.mantissa = 0;
+        answer.power2   = fmt->infinite_power;
     }
+    return answer;
 }
 
+#define DECIMAL_MAX_DIGITS  768
+#define DECIMAL_POINT_RANGE 2047
+#define DECIMAL_MAX_SHIFT   60
 
-void string_write_f64(String* str, f64 val) {
-    u64 length = 0;
-    s64 whole = (s64)val;
-    val -= whole;
-    b8 neg = (whole < 0);
-    if (neg) {
-        str->buffer[str->length] = '-';
-        str->length += 1;
-        whole = -whole;
-    }
-    if (whole == 0) {
-        str->buffer[str->length] = '0';
-        str->length += 1;
-    }
-    s64 whole_aux = whole;
-    while (whole_aux != 0) {
-        whole_aux /= 10;
-        length += 1;
+// Value is `0.digits * 10^decimal_point`, digits are stored as 0-9.
+typedef struct {
+    u32 num_digits;
+    s32 decimal_point;
+    b8  truncated; // Nonzero digits were dropped past DECIMAL_MAX_DIGITS.
+    u8  digits[DECIMAL_MAX_DIGITS];
+} BigDecimal;
+
+local void decimal_trim(BigDecimal* d) {
+    while (d->num_digits > 0 && d->digits[d->num_digits - 1] == 0) d->num_digits--;
+}
+
+// `text` holds an already validated number without its sign.
+local void decimal_parse(BigDecimal* d, const u8* text, u64 length) {
+    u64 pos         = 0;
+    u32 count       = 0;
+    u32 significant = 0;
+    s32 point       = 0;
+
+    while (pos < length && text[pos] == '0') pos++;
+    while (pos < length && is_digit(text[pos])) {
+        if (count < DECIMAL_MAX_DIGITS) d->digits[count] = text[pos] - '0';
+        count++;
+        if (text[pos] != '0') significant = count;
+        pos++;
     }
-    for (s32 i = length - 1; i >= 0; i--) {
-        str->buffer[str->length + i] = '0' + (whole % 10);
-        whole /= 10;
+    point = (s32)MIN(count, DECIMAL_POINT_RANGE);
+    if (pos < length && text[pos] == '.') {
+        pos++;
+        if (count == 0) {
+            while (pos < length && text[pos] == '0') {
+                if (point > -DECIMAL_POINT_RANGE) point--;
+                pos++;
+            }
+        }
+        while (pos < length && is_digit(text[pos])) {
+            if (count < DECIMAL_MAX_DIGITS) d->digits[count] = text[pos] - '0';
+            count++;
+            if (text[pos] != '0') significant = count;
+            pos++;
+        }
     }
-    str->length += length;
-    str->buffer[str->length] = '.';
-    str->length += 1;
-    for (s8 prec = 0; prec < 12; prec++) {
-        val *= 10;
-        s32 digit = (s32)val;
-        str->buffer[str->length] = '0' + digit;
-        str->length += 1;
-        val -= digit;
+
+    d->decimal_point = point;
+    d->num_digits    = MIN(significant, DECIMAL_MAX_DIGITS);
+    d->truncated     = significant > DECIMAL_MAX_DIGITS;
+
+    if (pos < length && (text[pos] == 'e' || text[pos] == 'E')) {
+        pos++;
+        b8 negative = pos < length && text[pos] == '-';
+        if (pos < length && (text[pos] == '-' || text[pos] == '+')) pos++;
+        s32 exponent = 0;
+        while (pos < length && is_digit(text[pos])) {
+            if (exponent < 0x10000) exponent = exponent * 10 + (text[pos] - '0');
+            pos++;
+        }
+        d->decimal_point += negative ? -exponent : exponent;
     }
 }
 
-void string_write_ptr(String* str, const void* ptr) {
-    u64 val = (u64)ptr;
-    u64 length = 0;
-    if (val == 0) {
-        str->buffer[str->length + length] = '0';
-        str->length += 1;
+local void decimal_left_shift(BigDecimal* d, u32 shift) {
+    if (d->num_digits == 0) return;
+
+    // A shift of at most 60 bits adds at most 19 digits.
+    u8  out[DECIMAL_MAX_DIGITS + 20];
+    u32 write = LEN(out);
+    u64 n     = 0;
+    for (s32 read = (s32)d->num_digits - 1; read >= 0; read--) {
+        n           += (u64)d->digits[read] << shift;
+        out[--write] = (u8)(n % 10);
+        n           /= 10;
     }
-    u64 aux_val = val;
-    while (aux_val != 0) {
-        aux_val /= 10;
-        length += 1;
+    while (n > 0) {
+        out[--write] = (u8)(n % 10);
+        n           /= 10;
     }
-    for (s32 i = length - 1; i >= 0; i--) {
-        str->buffer[str->length + i] = '0' + (val % 10);
-        val /= 10;
+
+    u32 count         = LEN(out) - write;
+    d->decimal_point += (s32)(count - d->num_digits);
+    if (count > DECIMAL_MAX_DIGITS) {
+        for (u32 i = DECIMAL_MAX_DIGITS; i < count; i++) {
+            if (out[write + i] != 0) d->truncated = true;
+        }
+        count = DECIMAL_MAX_DIGITS;
     }
-    str->length += length;
+    memcpy(d->digits, out + write, count);
+    d->num_digits = count;
+    decimal_trim(d);
 }
 
-void string_null(String* str) {
-    str->buffer[str->length] = 0;
-    str->length += 1;
-}
+local void decimal_right_shift(BigDecimal* d, u32 shift) {
+    u32 read  = 0;
+    u32 write = 0;
+    u64 n     = 0;
+    while ((n >> shift) == 0) {
+        if (read < d->num_digits) {
+            n = n * 10 + d->digits[read++];
+        } else if (n == 0) {
+            return;
+        } else {
+            while ((n >> shift) == 0) {
+                n *= 10;
+                read++;
+            }
+            break;
+        }
+    }
 
-void string_newline(String* str) {
-    str->buffer[str->length] = '\n';
-    str->length += 1;
-}
+    d->decimal_point -= (s32)(read - 1);
+    if (d->decimal_point < -DECIMAL_POINT_RANGE) {
+        d->num_digits    = 0;
+        d->decimal_point = 0;
+        d->truncated     = false;
+        return;
+    }
 
-void string_reset(String* str) {
-    str->length = 0;
+    u64 mask = (1ull << shift) - 1;
+    while (read < d->num_digits) {
+        u8 digit          = (u8)(n >> shift);
+        n                 = (n & mask) * 10 + d->digits[read++];
+        d->digits[write++] = digit;
+    }
+    while (n > 0) {
+        u8 digit = (u8)(n >> shift);
+        n        = (n & mask) * 10;
+        if (write < DECIMAL_MAX_DIGITS) {
+            d->digits[write++] = digit;
+        } else if (digit > 0) {
+            d->truncated = true;
+        }
+    }
+    d->num_digits = write;
+    decimal_trim(d);
 }
 
-char* string_to_cstr(String* str) {
-    str->buffer[str->length] = 0;
-    return (char*)str->buffer;
-}
+// Integer part rounded half to even.
+local u64 decimal_round(const BigDecimal* d) {
+    if (d->num_digits == 0 || d->decimal_point < 0) return 0;
+    if (d->decimal_point > 18) return ALL64;
 
-void string_print(const String str) {
-#if defined(__unix)
-	write(1, str.buffer, str.length);
-#else
-	HANDLE handle = GetStdHandle(STD_OUTPUT_HANDLE);
-	WriteFile(handle, str.buffer, str.length, NULL, NULL);
-#endif
+    u32 point = (u32)d->decimal_point;
+    u64 n     = 0;
+    for (u32 i = 0; i < point; i++) {
+        n = n * 10 + (i < d->num_digits ? d->digits[i] : 0);
+    }
+    b8 round_up = false;
+    if (point < d->num_digits) {
+        round_up = d->digits[point] >= 5;
+        if (d->digits[point] == 5 && point + 1 == d->num_digits) {
+            round_up = d->truncated || (point > 0 && (d->digits[point - 1] & 1));
+        }
+    }
+    return n + round_up;
 }
 
-void string_println(const String str) {
-#if defined(__unix)
-    write(1, str.buffer, str.length);
-    write(1, "\n", 1);
-#else
-    HANDLE handle = GetStdHandle(STD_OUTPUT_HANDLE);
-    WriteFile(handle, str.buffer, str.length, NULL, NULL);
-    WriteFile(handle, "\n", 1, NULL, NULL);
-#endif
-}
+local BinaryFloat decimal_to_binary(const FloatFormat* fmt, BigDecimal* d) {
+    persist const u8 powers[] = { 0, 3, 6, 9, 13, 16, 19, 23, 26, 29, 33, 36, 39, 43, 46, 49, 53, 56, 59 };
+    BinaryFloat zero     = { 0, 0 };
+    BinaryFloat infinity = { 0, fmt->infinite_power };
 
-void string_eprint(const String str) {
-#if defined(__unix)
-	write(2, str.buffer, str.length);
-#else
-	HANDLE handle = GetStdHandle(STD_ERROR_HANDLE);
-	WriteFile(handle, str.buffer, str.length, NULL, NULL);
-#endif
-}
+    if (d->num_digits == 0 || d->decimal_point < -324) return zero;
+    if (d->decimal_point >= 310) return infinity;
 
-void string_eprintln(const String str) {
-#if defined(__unix)
-    write(2, str.buffer, str.length);
-    write(2, "\n", 1);
-#else
-    HANDLE handle = GetStdHandle(STD_ERROR_HANDLE);
-    WriteFile(handle, str.buffer, str.length, NULL, NULL);
-    WriteFile(handle, "\n", 1, NULL, NULL);
-#endif
-}
+    // Scale by powers of two until the value sits in [1/2, 1).
+    s32 exp2 = 0;
+    while (d->decimal_point > 0) {
+        u32 n     = (u32)d->decimal_point;
+        u32 shift = n < LEN(powers) ? powers[n] : DECIMAL_MAX_SHIFT;
+        decimal_right_shift(d, shift);
+        if (d->decimal_point < -DECIMAL_POINT_RANGE) return zero;
+        exp2 += (s32)shift;
+    }
+    while (d->decimal_point <= 0) {
+        u32 shift;
+        if (d->decimal_point == 0) {
+            if (d->digits[0] >= 5) break;
+            shift = d->digits[0] < 2 ? 2 : 1;
+        } else {
+            u32 n = (u32)-d->decimal_point;
+            shift = n < LEN(powers) ? powers[n] : DECIMAL_MAX_SHIFT;
+        }
+        decimal_left_shift(d, shift);
+        if (d->decimal_point > DECIMAL_POINT_RANGE) return infinity;
+        exp2 -= (s32)shift;
+    }
+    exp2--;
 
-String string_concat(Arena* arena, const String str1, const String str2) {
-	u64 new_length = str1.length + str2.length;
-	u8* new_str = push_array(arena, u8, new_length);
-	memcpy(new_str, str1.buffer, str1.length);
-	memcpy(new_str + str1.length, str2.buffer, str2.length);
+    while (fmt->min_exponent + 1 > exp2) {
+        u32 n = (u32)(fmt->min_exponent + 1 - exp2);
+        if (n > DECIMAL_MAX_SHIFT) n = DECIMAL_MAX_SHIFT;
+        decimal_right_shift(d, n);
+        exp2 += (s32)n;
+    }
+    if (exp2 - fmt->min_exponent >= fmt->infinite_power) return infinity;
 
-	return (String) {
-		.buffer = new_str,
-		.length = new_length,
-	};
-}
+    decimal_left_shift(d, fmt->mantissa_bits + 1);
+    u64 mantissa = decimal_round(d);
+    if (mantissa >= (2ull << fmt->mantissa_bits)) {
+        decimal_right_shift(d, 1);
+        exp2++;
+        mantissa = decimal_round(d);
+        if (exp2 - fmt->min_exponent >= fmt->infinite_power) return infinity;
+    }
 
-String string_slice(const String str, const u64 init, const u64 end) {
-	return (String) {
-		.buffer = str.buffer + init,
-		.length = end - init,
-	};
+    BinaryFloat answer;
+    answer.power2 = exp2 - fmt->min_exponent;
+    if (mantissa < (1ull << fmt->mantissa_bits)) answer.power2--;
+    answer.mantissa = mantissa & ((1ull << fmt->mantissa_bits) - 1);
+    return answer;
 }
 
-void string_upper(String str) {
-	for (u64 i = 0; i < str.length; i++) {
-		u8* aux = str.buffer + i;
-		if (*aux >= 'a' && *aux <= 'z') *aux -= 32;
-	}
+// Case insensitive match of the lowercase `word` at `pos`.
+local b8 match_word(const String str, u64 pos, const char* word) {
+    for (; *word; word++, pos++) {
+        if (pos >= str.length || (str.buffer[pos] | 0x20) != (u8)*word) return false;
+    }
+    return true;
 }
 
-String string_upper_new(Arena* arena, const String str) {
-	u8* new_str = push_array(arena, u8, str.length);
-	for (u64 i = 0; i < str.length; i++) {
-		u8* aux = str.buffer + i;
-		if (*aux >= 'a' && *aux <= 'z') new_str[i] = (*aux) - 32;
-		else new_str[i] = *aux;
-	}
+// Fills `bits` with the IEEE representation for `fmt` and returns the status.
+local ParseResult parse_float(const String str, const FloatFormat* fmt, u64* bits) {
+    ParseResult result = { .status = PARSE_INVALID };
+    u64 pos = skip_blanks(str);
+    b8  negative = false;
+    if (pos < str.length && (str.buffer[pos] == '-' || str.buffer[pos] == '+')) {
+        negative = str.buffer[pos] == '-';
+        pos++;
+    }
+    u64 sign = (u64)negative << fmt->sign_index;
+    u64 infinite_bits = (u64)fmt->infinite_power << fmt->mantissa_bits;
 
-	return (String) {
-		.buffer = new_str,
-		.length = str.length,
-	};
-}
+    if (match_word(str, pos, "nan")) {
+        *bits           = sign | infinite_bits | (1ull << (fmt->mantissa_bits - 1));
+        result.consumed = pos + 3;
+        result.status   = PARSE_OK;
+        return result;
+    }
+    if (match_word(str, pos, "inf")) {
+        *bits           = sign | infinite_bits;
+        result.consumed = pos + (match_word(str, pos, "infinity") ? 8 : 3);
+        result.status   = PARSE_OK;
+        return result;
+    }
 
-void string_lower(String str) {
-    for (u64 i = 0; i < str.length; i++) {
-		u8* aux = str.buffer + i;
-		if (*aux >= 'A' && *aux <= 'Z') *aux += 32;
-	}
-}
+    const u8* buf   = str.buffer;
+    u64 length      = str.length;
+    u64 start       = pos;
+    u64 w           = 0;
+    u64 digit_count = 0;
 
-String string_lower_new(Arena* arena, const String str) {
-    u8* new_str = push_array(arena, u8, str.length);
-	for (u64 i = 0; i < str.length; i++) {
-		u8* aux = str.buffer + i;
-		if (*aux >= 'A' && *aux <= 'Z') new_str[i] = (*aux) + 32;
-		else new_str[i] = *aux;
-	}
+    // Digits accumulate eight at a time, `w` may wrap and is redone below
+    // when there are more than nineteen of them.
+    while (pos + 8 <= length && swar_all_digits(load_u64(buf + pos))) {
+        w    = w * 100000000 + swar_parse8(load_u64(buf + pos));
+        pos += 8;
+    }
+    while (pos < length && is_digit(buf[pos])) w = w * 10 + (buf[pos++] - '0');
+    u64 int_end  = pos;
+    digit_count  = int_end - start;
+    s64 exponent = 0;
+    if (pos < length && buf[pos] == '.') {
+        pos++;
+        u64 frac_start = pos;
+        while (pos + 8 <= length && swar_all_digits(load_u64(buf + pos))) {
+            w    = w * 100000000 + swar_parse8(load_u64(buf + pos));
+            pos += 8;
+        }
+        while (pos < length && is_digit(buf[pos])) w = w * 10 + (buf[pos++] - '0');
+        exponent     = -(s64)(pos - frac_start);
+        digit_count += pos - frac_start;
+    }
+    if (digit_count == 0) return result;
+    u64 mantissa_end = pos;
 
-	return (String) {
-		.buffer    = new_str,
-		.length = str.length,
-	};
-}
+    s64 exp_number = 0;
+    if (pos < length && (buf[pos] == 'e' || buf[pos] == 'E')) {
+        u64 exp_pos = pos + 1;
+        b8  exp_negative = exp_pos < length && buf[exp_pos] == '-';
+        if (exp_pos < length && (buf[exp_pos] == '-' || buf[exp_pos] == '+')) exp_pos++;
+        if (exp_pos < length && is_digit(buf[exp_pos])) {
+            while (exp_pos < length && is_digit(buf[exp_pos])) {
+                if (exp_number < 0x10000) exp_number = exp_number * 10 + (buf[exp_pos] - '0');
+                exp_pos++;
+            }
+            if (exp_negative) exp_number = -exp_number;
+            exponent += exp_number;
+            pos       = exp_pos;
+        }
+    }
+    result.consumed = pos;
+    result.status   = PARSE_OK;
 
-b8 string_equals(const String str1, const String str2) {
-    if (str1.length != str2.length) return false;
-	for (u64 i = 0; i < str1.length; i++) {
-		if (str1.buffer[i] != str2.buffer[i]) return false;
-	}
-	return true;
-}
+    b8 too_many_digits = false;
+    if (digit_count > 19) {
+        for (u64 i = start; i < mantissa_end && (buf[i] == '0' || buf[i] == '.'); i++) {
+            if (buf[i] == '0') digit_count--;
+        }
+        if (digit_count > 19) {
+            // Keep the leading nineteen significant digits, the rest only
+            // decide whether `w` or `w + 1` is the better bound.
+            too_many_digits = true;
+            w = 0;
+            u64 i = start;
+            while (i < mantissa_end && (buf[i] == '0' || buf[i] == '.')) i++;
+            u64 first = i;
+            while (w < 1000000000000000000ull && i < int_end) w = w * 10 + (buf[i++] - '0');
+            if (w >= 1000000000000000000ull) {
+                exponent = (s64)(int_end - i) + exp_number;
+            } else {
+                i = MAX(first, int_end + 1);
+                while (w < 1000000000000000000ull && i < mantissa_end) w = w * 10 + (buf[i++] - '0');
+                exponent = (s64)(int_end + 1) - (s64)i + exp_number;
+            }
+        }
+    }
 
-b8 string_cmp(const String str1, const char* str2) {
-    if (str2[str1.length] != 0) return false;
-    for (u64 i = 0; i < str1.length; i++) {
-        if (str1.buffer[i] != str2[i]) return false;
+    if (!too_many_digits && w <= fmt->max_exact_mantissa &&
+        exponent >= -fmt->max_exact_power && exponent <= fmt->max_exact_power) {
+        // Clinger: both operands are exact, so one rounding gives the answer.
+        if (fmt == &f64_format) {
+            f64 value = (f64)w;
+            value = exponent < 0 ? value / exact_pow10_f64[-exponent] : value * exact_pow10_f64[exponent];
+            memcpy(bits, &value, sizeof(value));
+        } else {
+            f32 value = (f32)w;
+            value = exponent < 0 ? value / exact_pow10_f32[-exponent] : value * exact_pow10_f32[exponent];
+            u32 bits32;
+            memcpy(&bits32, &value, sizeof(bits32));
+            *bits = bits32;
+        }
+        *bits |= sign;
+        return result;
     }
-    return true;
-}
 
-s8 string_to_s8(const String str) {
-    s8 result = 0;
-	s8 negative = 0;
-	for (u64 i = 0; i < str.length; i++) {
-		while (str.buffer[i] == ' ') {
-			i++;
-		}
-		if (str.buffer[i] == '-') {
-			negative = -1;
-			i++;
-		}
-		while (str.buffer[i] >= '0' && str.buffer[i] <= '9') {
-			result *= 10;
-			result += str.buffer[i] - '0';
-			i++;
-		}
-	}
-
-	return result * negative;
-}
+    BinaryFloat answer = eisel_lemire(fmt, exponent, w);
+    if (too_many_digits && answer.power2 >= 0) {
+        BinaryFloat upper = eisel_lemire(fmt, exponent, w + 1);
+        if (upper.power2 != answer.power2 || upper.mantissa != answer.mantissa) answer.power2 = -1;
+    }
+    if (answer.power2 < 0) {
+        BigDecimal decimal;
+        decimal_parse(&decimal, buf + start, pos - start);
+        answer = decimal_to_binary(fmt, &decimal);
+    }
 
-s16 string_to_s16(const String str) {
-    s16 result = 0;
-	s16 negative = 0;
-	for (u64 i = 0; i < str.length; i++) {
-		while (str.buffer[i] == ' ') {
-			i++;
-		}
-		if (str.buffer[i] == '-') {
-			negative = -1;
-			i++;
-		}
-		while (str.buffer[i] >= '0' && str.buffer[i] <= '9') {
-			result *= 10;
-			result += str.buffer[i] - '0';
-			i++;
-		}
-	}
-
-	return result * negative;
+    if (answer.power2 == fmt->infinite_power) result.status = PARSE_OVERFLOW;
+    *bits = sign | answer.mantissa | ((u64)answer.power2 << fmt->mantissa_bits);
+    return result;
 }
 
-s32 string_to_s32(const String str) {
-    s32 result = 0;
-	s32 negative = 0;
-	for (u64 i = 0; i < str.length; i++) {
-		while (str.buffer[i] == ' ') {
-			i++;
-		}
-		if (str.buffer[i] == '-') {
-			negative = -1;
-			i++;
-		}
-		while (str.buffer[i] >= '0' && str.buffer[i] <= '9') {
-			result *= 10;
-			result += str.buffer[i] - '0';
-			i++;
-		}
-	}
-
-	return result * negative;
+ParseResult string_parse_f32(const String str) {
+    u64 bits = 0;
+    ParseResult result = parse_float(str, &f32_format, &bits);
+    u32 bits32 = (u32)bits;
+    result.u   = 0;
+    memcpy(&result.f, &bits32, sizeof(bits32));
+    return result;
 }
 
-s64 string_to_s64(const String str) {
-    s64 result = 0;
-	s64 negative = 0;
-	for (u64 i = 0; i < str.length; i++) {
-		while (str.buffer[i] == ' ') i++;
-		if (str.buffer[i] == '-') {
-			negative = -1;
-			i++;
-		}
-		while (str.buffer[i] >= '0' && str.buffer[i] <= '9') {
-			result *= 10;
-			result += str.buffer[i] - '0';
-			i++;
-		}
-	}
-
-	return result * negative;
+ParseResult string_parse_f64(const String str) {
+    u64 bits = 0;
+    ParseResult result = parse_float(str, &f64_format, &bits);
+    memcpy(&result.d, &bits, sizeof(bits));
+    return result;
 }
 
-u8 string_to_u8(const String str) {
-    u8 result = 0;
-	for (u64 i = 0; i < str.length; i++) {
-		while (str.buffer[i] == ' ') i++;
-		while (str.buffer[i] >= '0' && str.buffer[i] <= '9') {
-			result *= 10;
-			result += str.buffer[i] - '0';
-			i++;
-		}
-	}
-
-	return result;
+f32 string_to_f32(const String str) {
+    return string_parse_f32(str).f;
 }
 
-u16 string_to_u16(const String str) {
-    u16 result = 0;
-	for (u64 i = 0; i < str.length; i++) {
-		while (str.buffer[i] == ' ') i++;
-		while (str.buffer[i] >= '0' && str.buffer[i] <= '9') {
-			result *= 10;
-			result += str.buffer[i] - '0';
-			i++;
-		}
-	}
-
-	return result;
+f64 string_to_f64(const String str) {
+    return string_parse_f64(str).d;
 }
 
-u32 string_to_u32(const String str) {
-    u32 result = 0;
-	for (u64 i = 0; i < str.length; i++) {
-		while (str.buffer[i] == ' ') i++;
-		while (str.buffer[i] >= '0' && str.buffer[i] <= '9') {
-			result *= 10;
-			result += str.buffer[i] - '0';
-			i++;
-		}
-	}
-
-	return result;
-}
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                               DYNAMIC ARRAY                               */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-u64 string_to_u64(const String str) {
-    u64 result = 0;
-	for (u64 i = 0; i < str.length; i++) {
-		while (str.buffer[i] == ' ') i++;
-		while (str.buffer[i] >= '0' && str.buffer[i] <= '9') {
-			result *= 10;
-			result += str.buffer[i] - '0';
-			i++;
-		}
-	}
+Array array_create(u64 type_size) {
+    Array da = {
+        .type_size = type_size,
+    };
 
-	return result;
+    return da;
 }
 
-Array array_create(u64 type_size) {
+Array array_create_arena(Arena* arena, u64 type_size) {
     Array da = {
+        .arena     = arena,
         .type_size = type_size,
     };
 
@@ -608,45 +5563,47 @@ Array array_create(u64 type_size) {
 }
 
 void array_reserve(Array* da, u64 cap) {
-    da->data = malloc(cap * da->type_size);
-    da->cap = cap;
+    if (cap <= da->cap) return;
+    array_resize(da, cap);
 }
 
-// void dynarray_reserve_arena(Array* da, Arena* a, u64 cap) {
-//     da->data = arena_alloc(a, cap * da->type_size);
-//     da->cap = cap;
-// }
+b8 array_resize(Array* da, u64 new_cap) {
+    void* data;
+    if (da->arena != NULL) {
+        data = arena_realloc(da->arena, da->data, da->cap * da->type_size, new_cap * da->type_size, 16);
+    } else {
+        data = realloc(da->data, new_cap * da->type_size);
+    }
+    // The old buffer is still intact when growing fails.
+    if (data == NULL && new_cap > 0) return false;
+    da->data = data;
+    da->cap  = new_cap;
+    if (da->len > new_cap) da->len = new_cap;
+    return true;
+}
 
-void array_resize(Array* da, u64 new_cap) {
-    da->data = realloc(da->data, new_cap * da->type_size);
-    da->cap = new_cap;
+// Makes room for one more element.
+local b8 array_grow(Array* da) {
+    if (da->len < da->cap) return true;
+    return array_resize(da, MAX(da->cap * 2, 2));
 }
 
 void array_push(Array* da, const void* val) {
-    if (da->len + 1 > da->cap) {
-        if (da->cap == 0) da->cap = 1;
-        array_resize(da, da->cap + da->cap);
-    }
+    if (!array_grow(da)) return;
     void* elem = (u8*)da->data + da->type_size * da->len;
     memcpy(elem, val, da->type_size);
     da->len += 1;
 }
 
 void array_pushf(Array* da, const void* val) {
-    if (da->len + 1 > da->cap) {
-        if (da->cap == 0) da->cap = 1;
-        array_resize(da, da->cap + da->cap);
-    }
+    if (!array_grow(da)) return;
     memmove((u8*)da->data + da->type_size, da->data, da->len * da->type_size);
     memcpy(da->data, val, da->type_size);
     da->len += 1;
 }
 
 void array_pushi(Array* da, const void* val, u64 idx) {
-    if (da->len + 1 > da->cap) {
-        if (da->cap == 0) da->cap = 1;
-        array_resize(da, da->cap + da->cap);
-    }
+    if (!array_grow(da)) return;
     if (idx == 0) {
         push_front(da, val);
         return;
@@ -683,7 +5640,7 @@ void array_clear(Array* da) {
 }
 
 void array_destroy(Array* da) {
-    free(da->data);
+    if (da->arena == NULL) free(da->data);
     da->data = NULL;
     da->len = 0;
     da->cap = 0;
@@ -46,6 +46,14 @@
 #define global  static
 #define persist static
 
+#if defined(__cplusplus)
+    #define per_thread thread_local
+#elif defined(_MSC_VER)
+    #define per_thread __declspec(thread)
+#else
+    #define per_thread _Thread_local
+#endif
+
 typedef unsigned char       u8;
 typedef unsigned short      u16;
 typedef unsigned int        u32;
@@ -126,12 +134,56 @@ extern "C" {
 #define GB(x) ((u64)(x) << 30)
 #define TB(x) ((u64)(x) << 40)
 
-#define DEFAULT_ARENA_SIZE GB(1)
+#define DEFAULT_ARENA_SIZE   GB(1)
+#define DEFAULT_ARENA_COMMIT KB(64)
+
+// Arena flags.
+#define ARENA_GROW     (1 << 0) // Chain a new block instead of returning NULL when full.
+#define ARENA_BORROWED (1 << 1) // Memory belongs to another arena, `arena_free` leaves it alone.
+#define ARENA_HUGE     (1 << 2) // Back the arena with huge pages, `cap` is rounded to `arena_huge_page_size()`.
+#define ARENA_LAZY     (1 << 3) // Trim with MADV_FREE instead of MADV_DONTNEED.
+#define ARENA_MAPPED   (1 << 4) // `buffer` is a file mapping made by `arena_load`.
+#define ARENA_READONLY (1 << 5) // Mapped without write access, nothing can be allocated or cleared.
 
+// Huge page size of this machine, read once from the kernel: the transparent
+// huge page size, else the hugetlbfs default, else 2MB.
+u64 arena_huge_page_size(void);
+
+#define HUGE_PAGE_SIZE arena_huge_page_size()
+
+// What actually backs an arena block.
+typedef enum {
+    ARENA_BACKING_PAGES,   // Regular pages.
+    ARENA_BACKING_HUGETLB, // Explicit huge pages (MAP_HUGETLB/MEM_LARGE_PAGES).
+    ARENA_BACKING_THP,     // Transparent huge pages (MADV_HUGEPAGE).
+} ArenaBacking;
+
+#if defined(SAMLIB_ARENA_STATS)
 typedef struct {
-	void* buffer;
-	u64   pos;
-	u64   cap;
+    u64 allocs;
+    u64 requested;  // Bytes asked for.
+    u64 padding;    // Bytes skipped to satisfy alignment.
+    u64 high_water; // Highest position reached across the block chain.
+    u64 failed;     // Allocations that returned NULL.
+} ArenaStats;
+#endif
+
+typedef struct Arena {
+	void*         buffer;
+	u64           pos;
+	u64           cap;
+	u64           commit;      // Bytes at the start of `buffer` that are readable/writable.
+	u64           commit_size; // Commit granularity, 0 means the whole `cap` is committed up front.
+	u64           base;        // Position of `buffer` inside the whole block chain.
+	struct Arena* prev;        // Previous block state, stored at the start of `buffer`.
+	u64           peak;        // Highest `pos` of the current block since it was last trimmed.
+	u64           retain;      // Bytes kept resident when `pos` rewinds, see `arena_set_retain`.
+	u64           map_size;    // Whole file mapping of an `arena_load` arena, header included.
+	u32           flags;
+	u32           backing;     // `ArenaBacking` of the current block.
+#if defined(SAMLIB_ARENA_STATS)
+	ArenaStats    stats;
+#endif
 } Arena;
 
 typedef struct {
@@ -142,20 +194,143 @@ typedef struct {
 // Create a new `Arena` of size `cap`. Minimum size is 4KB, if a smaller size is
 // given it will still allocate 4KB.
 Arena arena_new(u64 cap);
+// Create a new `Arena` that only reserves `cap` bytes of address space and
+// commits pages in `commit_size` chunks as `pos` advances. A `commit_size` of 0
+// behaves like `arena_new`. With `ARENA_GROW` a full arena chains a new block
+// of (at least) `cap` bytes instead of returning NULL. With `ARENA_HUGE` fully
+// committed arenas try explicit huge pages first, and every arena falls back to
+// transparent huge pages; `backing` tells which one it got.
+Arena arena_new_ex(u64 cap, u64 commit_size, u32 flags);
 void* arena_alloc(Arena* a, u64 size, u64 alignment);
+// `arena_alloc` that also records `file`/`line` in the callsite table when
+// built with SAMLIB_ARENA_STATS, see `push_array_tagged`.
+void* arena_alloc_tagged(Arena* a, u64 size, u64 alignment, const char* file, u32 line);
+// Resize an allocation of `old_size` bytes. When `ptr` is the last allocation
+// of the arena it grows or shrinks in place, otherwise the data is copied into
+// a new allocation.
+void* arena_realloc(Arena* a, void* ptr, u64 old_size, u64 new_size, u64 alignment);
+// Thread-safe `arena_alloc`, any number of threads may bump the same arena as
+// long as nothing else touches it meanwhile. Never chains, returns NULL once
+// `cap` is reached.
+void* arena_alloc_atomic(Arena* a, u64 size, u64 alignment);
+// Carve a `size` bytes slab out of `shared` with a single atomic bump and return
+// it as an arena the calling thread can `arena_alloc` from without contention.
+Arena arena_slab(Arena* shared, u64 size);
 void* arena_pop(Arena* a, u64 size);
+void  arena_pop_to(Arena* a, u64 pos);
+u64   arena_pos(const Arena* a);
 void  arena_reset(Arena* a);
+// Zero the used memory and reset. Big ranges are zeroed by giving the pages
+// back to the OS instead of a memset.
 void  arena_clear(Arena* a);
+// Keep at most `retain` bytes resident when `pos` rewinds through
+// `arena_pop_to`, `arena_reset` or `temp_arena_end`, pages the arena touched
+// above it are returned to the OS. Defaults to MAX_U64, i.e. never trim.
+void  arena_set_retain(Arena* a, u64 retain);
+// Dump the statistics of `a` and of every tagged callsite that allocated from
+// it (callsites are keyed by the address of `a`). Needs SAMLIB_ARENA_STATS.
+void  arena_stats_report(const Arena* a, FILE* out);
 void  arena_free(Arena* a);
 
+// Write `buffer[0..pos]` of `a` behind a small header so `arena_load` can map it
+// back. Fails for arenas with chained blocks. Store internal references as
+// `RelPtr` so they survive being mapped at a different address.
+b8    arena_save(const Arena* a, const char* path);
+// Map a snapshot written by `arena_save`. It is read-only unless
+// `copy_on_write`, in which case writes stay private to the process. The
+// arena is full (`pos == cap`), release it with `arena_free`. A read-only
+// arena is flagged `ARENA_READONLY`: it may be rewound, but `arena_alloc`,
+// `arena_realloc` and `arena_alloc_atomic` return NULL and `arena_clear` does
+// nothing.
+Arena arena_load(const char* path, b8 copy_on_write);
+
 TempArena temp_arena_begin(Arena* a);
 void      temp_arena_end(TempArena temp);
 
+// Self-relative pointer, stores the distance from its own address so it stays
+// valid wherever the memory holding it is mapped. 0 is NULL.
+typedef s64 RelPtr;
+
+#define relptr_set(rp, ptr) (*(rp) = (ptr) ? (RelPtr)((u8*)(ptr) - (u8*)(rp)) : 0)
+#define relptr_get(rp, T)   (*(rp) ? (T*)((u8*)(rp) + *(rp)) : (T*)NULL)
+
+#define SCRATCH_ARENA_COUNT 2
+
+// Begin a `TempArena` on one of the calling thread's scratch arenas that is not
+// in `conflicts` (usually the arenas the caller was handed). Scratch arenas are
+// reserved on first use and grow on demand.
+TempArena scratch_begin(Arena** conflicts, u64 count);
+void      scratch_end(TempArena temp);
+// Release the calling thread's scratch arenas, e.g. right before it exits.
+void      scratch_free(void);
+
 #define arena_default()     arena_new(DEFAULT_ARENA_SIZE)
+#define arena_reserve(cap)  arena_new_ex((cap), DEFAULT_ARENA_COMMIT, ARENA_GROW)
 #define push_array(a, T, c) (T*)arena_alloc((a), sizeof(T) * (c), alignof(T))
 #define push_type(a, T)     (T*)arena_alloc((a), sizeof(T), alignof(T))
 #define pop_type(a, T)      (T*)arena_pop((a), sizeof(T))
 
+#if defined(SAMLIB_ARENA_STATS)
+    #define push_array_tagged(a, T, c) (T*)arena_alloc_tagged((a), sizeof(T) * (c), alignof(T), __FILE__, __LINE__)
+    #define push_type_tagged(a, T)     (T*)arena_alloc_tagged((a), sizeof(T), alignof(T), __FILE__, __LINE__)
+#else
+    #define push_array_tagged(a, T, c) push_array(a, T, c)
+    #define push_type_tagged(a, T)     push_type(a, T)
+#endif
+
+#define POOL_SLAB_SIZE  KB(64)
+#define POOL_CACHE_SIZE 64
+
+// Fixed-size object allocator with an intrusive free list, slabs are carved
+// out of `arena` and live as long as it does.
+typedef struct {
+    Arena* arena;
+    void*  free_list;
+    u8*    slab;       // Unused part of the current slab.
+    u64    slab_left;  // Elements left in `slab`.
+    u64    slab_count; // Elements per slab.
+    u64    elem_size;
+    u64    align;
+    u32    lock;       // Only taken by `PoolCache` refills and flushes.
+} Pool;
+
+// Thread-local front end for a `Pool` shared between threads. Allocations and
+// frees stay local and only move `POOL_CACHE_SIZE / 2` objects at a time
+// to/from the pool. Once a pool has caches every thread must go through one.
+typedef struct {
+    Pool* pool;
+    void* free_list;
+    u64   count;
+} PoolCache;
+
+Pool      pool_new(Arena* arena, u64 elem_size, u64 align);
+void*     pool_alloc(Pool* pool);
+void      pool_free(Pool* pool, void* ptr);
+PoolCache pool_cache_new(Pool* pool);
+void*     pool_cache_alloc(PoolCache* cache);
+void      pool_cache_free(PoolCache* cache, void* ptr);
+// Give every cached object back to the pool, e.g. before the thread exits.
+void      pool_cache_flush(PoolCache* cache);
+
+#define pool_of(a, T)      pool_new((a), sizeof(T), alignof(T))
+#define pool_push(p, T)    (T*)pool_alloc((p))
+#define pool_cached(c, T)  (T*)pool_cache_alloc((c))
+
+// Two-Level Segregated Fit allocator: variable-size alloc/realloc/free in
+// bounded O(1) time over memory mapped with `arena_new`. Allocations are 16
+// bytes aligned. When it runs out a new region of at least `cap` bytes is
+// mapped, which is the only step that isn't O(1).
+typedef struct Tlsf Tlsf;
+
+Tlsf* tlsf_new(u64 cap);
+void* tlsf_alloc(Tlsf* t, u64 size);
+void* tlsf_realloc(Tlsf* t, void* ptr, u64 size);
+void  tlsf_free(Tlsf* t, void* ptr);
+void  tlsf_destroy(Tlsf* t);
+
+#define tlsf_push_array(t, T, c) (T*)tlsf_alloc((t), sizeof(T) * (c))
+#define tlsf_push_type(t, T)     (T*)tlsf_alloc((t), sizeof(T))
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 /*                                  STRINGS                                  */
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
@@ -166,6 +341,43 @@ typedef struct {
 	u64 length;
 } String;
 
+typedef enum {
+    PARSE_OK,
+    PARSE_INVALID,  // No digits were found.
+    PARSE_OVERFLOW, // The value does not fit the requested type.
+} ParseStatus;
+
+typedef struct {
+    union {
+        u64 u;
+        s64 s;
+        f32 f;
+        f64 d;
+    };
+    u64         consumed; // Bytes read from the start of the string.
+    ParseStatus status;
+} ParseResult;
+
+// Splits a string on a byte or substring delimiter, yielding slices of the
+// original buffer. Adjacent delimiters give empty tokens, an empty substring
+// delimiter gives the whole string as one token.
+typedef struct {
+    String rest;
+    String delim;
+    u8     byte;
+    b8     by_byte; // Split on `byte` instead of `delim`.
+    b8     done;
+} StringSplitIter;
+
+#define STRING_NOT_FOUND ALL64
+
+typedef struct {
+    String str;
+    u64    pos; // Byte offset of the next codepoint.
+} Utf8Iter;
+
+#define UTF8_REPLACEMENT 0xFFFD
+
 String string_init(u8* buffer);
 void   string_write_str(String* str, const char* s);
 void   string_write_s8(String* str, s8 val);
@@ -176,8 +388,17 @@ void   string_write_u8(String* str, u8 val);
 void   string_write_u16(String* str, u16 val);
 void   string_write_u32(String* str, u32 val);
 void   string_write_u64(String* str, u64 val);
+// Shortest representation that reads back to the same value.
 void   string_write_f32(String* str, f32 val);
 void   string_write_f64(String* str, f64 val);
+// Fixed notation with `precision` fractional digits (at most 19), rounded half
+// to even like printf. Integers past 2^64 print their shortest digits followed
+// by zeros.
+void   string_write_f32_prec(String* str, f32 val, u32 precision);
+void   string_write_f64_prec(String* str, f64 val, u32 precision);
+// Lowercase hexadecimal without prefix.
+void   string_write_hex(String* str, u64 val);
+// Hexadecimal with a "0x" prefix.
 void   string_write_ptr(String* str, const void* ptr);
 void   string_null(String* str);
 void   string_newline(String* str);
@@ -187,14 +408,50 @@ void   string_print(const String str);
 void   string_println(const String str);
 void   string_eprint(const String str);
 void   string_eprintln(const String str);
+// When `str1` ends at the top of `arena` (e.g. it is the last allocation or a
+// suffix of it) it is extended in place and the result shares its bytes,
+// otherwise both are copied. Empty String when the arena is full.
 String string_concat(Arena* arena, const String str1, const String str2);
 String string_slice(const String str, const u64 init, const u64 end);
+// ASCII letters only, other bytes are copied unchanged.
 void   string_upper(String str);
 void   string_lower(String str);
 String string_upper_new(Arena* arena, const String str);
 String string_lower_new(Arena* arena, const String str);
 b8     string_equals(const String str1, const String str2);
 b8     string_cmp(const String str1, const char* str2);
+// Byte-wise ordering like memcmp, a prefix sorts first.
+s32    string_compare(const String str1, const String str2);
+// Index of the first (or last) match, STRING_NOT_FOUND otherwise. An empty
+// needle matches at the start (or end).
+u64    string_find(const String str, const String needle);
+u64    string_find_byte(const String str, u8 byte);
+u64    string_rfind(const String str, const String needle);
+b8     string_contains(const String str, const String needle);
+StringSplitIter string_split(const String str, const String delim);
+StringSplitIter string_split_byte(const String str, u8 delim);
+// Writes the next token and returns true, false once the string is consumed.
+b8     string_split_next(StringSplitIter* it, String* token);
+// Strict UTF-8: rejects overlong forms, surrogates and values past U+10FFFF.
+b8     string_utf8_validate(const String str);
+// Codepoints in valid UTF-8, i.e. bytes that are not continuation bytes.
+u64    string_utf8_count(const String str);
+Utf8Iter string_utf8_iter(const String str);
+// Decodes the next codepoint, an invalid byte yields UTF8_REPLACEMENT and is
+// skipped on its own.
+b8     string_utf8_next(Utf8Iter* it, u32* codepoint);
+// Leading blanks and a sign are skipped, parsing stops at the first byte that
+// is not a digit. On overflow the value saturates to the type's limit and
+// `consumed` still covers every digit.
+ParseResult string_parse_s8(const String str);
+ParseResult string_parse_s16(const String str);
+ParseResult string_parse_s32(const String str);
+ParseResult string_parse_s64(const String str);
+ParseResult string_parse_u8(const String str);
+ParseResult string_parse_u16(const String str);
+ParseResult string_parse_u32(const String str);
+ParseResult string_parse_u64(const String str);
+// Shorthands for `string_parse_*` that drop the status.
 s8     string_to_s8(const String str);
 s16    string_to_s16(const String str);
 s32    string_to_s32(const String str);
@@ -203,14 +460,177 @@ u8     string_to_u8(const String str);
 u16    string_to_u16(const String str);
 u32    string_to_u32(const String str);
 u64    string_to_u64(const String str);
-#if 0
+// Correctly rounded, also accepts "inf", "infinity" and "nan" in any case. An
+// out of range value gives infinity with PARSE_OVERFLOW.
+ParseResult string_parse_f32(const String str);
+ParseResult string_parse_f64(const String str);
 f32    string_to_f32(const String str);
 f64    string_to_f64(const String str);
+
+// Growable string over an arena. Writes never run past the buffer: it grows
+// through `arena_realloc`, in place while it is the arena's last allocation.
+typedef struct {
+    Arena* arena;
+    String str;
+    u64    cap;
+} StringBuilder;
+
+// Upper bounds for one write, so each call reserves once and then reuses the
+// plain `string_write_*` routines.
+#define BUILDER_INT_MAX   21  // Sign and twenty digits.
+#define BUILDER_FLOAT_MAX 32  // "-2.2250738585072014e-308" and friends.
+#define BUILDER_PREC_MAX  330 // Sign, 309 integer digits, point, 19 fractional.
+
+StringBuilder string_builder(Arena* arena, u64 cap);
+// Makes room for `extra` more bytes. Returns false and leaves the builder as
+// it was when the arena is out of space, the appends below then drop the write.
+b8     string_builder_reserve(StringBuilder* sb, u64 extra);
+void   string_builder_bytes(StringBuilder* sb, const void* data, u64 length);
+void   string_builder_str(StringBuilder* sb, const char* s);
+void   string_builder_string(StringBuilder* sb, const String str);
+void   string_builder_byte(StringBuilder* sb, u8 byte);
+void   string_builder_s8(StringBuilder* sb, s8 val);
+void   string_builder_s16(StringBuilder* sb, s16 val);
+void   string_builder_s32(StringBuilder* sb, s32 val);
+void   string_builder_s64(StringBuilder* sb, s64 val);
+void   string_builder_u8(StringBuilder* sb, u8 val);
+void   string_builder_u16(StringBuilder* sb, u16 val);
+void   string_builder_u32(StringBuilder* sb, u32 val);
+void   string_builder_u64(StringBuilder* sb, u64 val);
+void   string_builder_f32(StringBuilder* sb, f32 val);
+void   string_builder_f64(StringBuilder* sb, f64 val);
+void   string_builder_f32_prec(StringBuilder* sb, f32 val, u32 precision);
+void   string_builder_f64_prec(StringBuilder* sb, f64 val, u32 precision);
+void   string_builder_hex(StringBuilder* sb, u64 val);
+void   string_builder_ptr(StringBuilder* sb, const void* ptr);
+void   string_builder_newline(StringBuilder* sb);
+void   string_builder_reset(StringBuilder* sb);
+// The built string, pointing into the builder's buffer.
+String string_builder_view(const StringBuilder* sb);
+// NUL terminates without counting it in the length. NULL when out of space.
+char*  string_builder_cstr(StringBuilder* sb);
+
+#if defined(__unix)
+typedef int   FileHandle;
+#else
+typedef void* FileHandle;
 #endif
 
+// Buffered output. Writes collect in the buffer and go out in one gathered
+// write once it would overflow or on `writer_flush`.
+typedef struct {
+    u8*        buffer;
+    u64        length;
+    u64        cap;
+    FileHandle fd;
+    b8         failed; // A write failed since the last flush.
+} Writer;
+
+Writer  writer_new(Arena* arena, FileHandle fd, u64 cap);
+// Shared writers for the standard streams, flushed at exit. They are not
+// thread safe.
+Writer* writer_stdout(void);
+Writer* writer_stderr(void);
+void    writer_write(Writer* w, const void* data, u64 length);
+void    writer_print(Writer* w, const String str);
+void    writer_println(Writer* w, const String str);
+// Returns false when any write since the last flush failed.
+b8      writer_flush(Writer* w);
+
+// Maps strings to dense u32 IDs, storing each distinct string once in the
+// arena. IDs stay valid for the interner's lifetime, so equal IDs mean equal
+// strings.
+typedef struct {
+    Arena*  arena;
+    String* strings; // Indexed by ID.
+    u64*    hashes;  // Indexed by ID.
+    u64*    slots;   // Open addressing, linear probing.
+    u32     count;
+    u32     cap;
+    u32     slot_count;
+} StringInterner;
+
+#define INTERNER_NOT_FOUND ALL32
+
+// Room for `cap` strings before the first resize.
+StringInterner interner_new(Arena* arena, u32 cap);
+// ID of `str`, adding a copy of it when it is new. INTERNER_NOT_FOUND when the
+// arena cannot fit a new string, the interner is left unchanged.
+u32    interner_intern(StringInterner* in, const String str);
+// ID of `str` or INTERNER_NOT_FOUND, never inserts.
+u32    interner_find(const StringInterner* in, const String str);
+String interner_get(const StringInterner* in, u32 id);
+void   interner_intern_many(StringInterner* in, const String* strs, u32* ids, u64 count);
+
 #define str_slice_end(str, init)  string_slice(str, init, str.length)
 #define str_slice_until(str, end) string_slice(str, 0, end)
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                  HASHING                                  */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// 64-bit non-cryptographic hash (wyhash). Output does not depend on the CPU.
+u64 mem_hash(const void* data, u64 length, u64 seed);
+u64 string_hash(const String str, u64 seed);
+
+// Incremental form of `mem_hash`: feeding the same bytes in any chunking
+// gives the same result.
+typedef struct {
+    u64 lanes[3];
+    u64 length;
+    u32 buffered;
+    u8  buffer[64]; // The last 16 hashed bytes, then up to 48 pending ones.
+} Hasher;
+
+Hasher hasher_new(u64 seed);
+void   hasher_update(Hasher* h, const void* data, u64 length);
+u64    hasher_finish(const Hasher* h);
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/*                                   FILES                                   */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+typedef struct {
+    String data;   // Read-only.
+    b8     mapped; // False when the bytes were read into the fallback arena.
+} MappedFile;
+
+// Maps a regular file read-only with sequential read-ahead hints. Pipes, files
+// reporting a size of 0 (procfs, sysfs) and others that cannot be mapped are
+// read into `fallback` instead (skipped when it is NULL). On failure
+// `data.buffer` is NULL.
+MappedFile file_map(const char* path, Arena* fallback);
+void       file_unmap(MappedFile* file);
+
+// Splits a stream (pipe, socket, stdin) into lines while a background thread
+// reads ahead into a ring of `chunk_size` buffers (1MB when 0).
+typedef struct LineReader LineReader;
+
+LineReader* line_reader_new(Arena* arena, FileHandle fd, u64 chunk_size);
+// Next line without its '\n', valid until the following call. Lines are
+// slices of the read buffers, only those crossing a chunk boundary are copied
+// into arena space reused from line to line. Returns false at end of input.
+b8          line_reader_next(LineReader* r, String* line);
+// Waits for the reader thread, which finishes its pending read first. Returns
+// false if a read failed or a line did not fit the arena.
+b8          line_reader_close(LineReader* r);
+
+// Writes without blocking the caller on the disk. Bytes are copied into one of
+// `buffer_count` buffers of `buffer_size` (8 of 256KB when 0). Full buffers go
+// to io_uring in batches, or to a writer thread where io_uring is missing, and
+// come back for reuse once written.
+typedef struct AsyncWriter AsyncWriter;
+
+AsyncWriter* async_writer_new(Arena* arena, FileHandle fd, u64 buffer_size, u32 buffer_count);
+// Waits only when every buffer is still queued for the disk.
+void         async_writer_write(AsyncWriter* w, const void* data, u64 length);
+void         async_writer_print(AsyncWriter* w, const String str);
+// Hands over the partial buffer and waits for every write. Returns false if
+// any write failed since the writer was created.
+b8           async_writer_flush(AsyncWriter* w);
+// Flushes and releases the ring or the thread. `fd` stays open.
+b8           async_writer_close(AsyncWriter* w);
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 /*                               DYNAMIC ARRAY                               */
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
@@ -221,13 +641,17 @@ typedef struct {
     void*  data;
     u64    cap;
     u64    len;
+    Arena* arena; // When set the array grows with `arena_realloc` instead of `realloc`.
 
     const u64 type_size;
 } Array;
 
 Array array_create(u64 type_size);
+Array array_create_arena(Arena* arena, u64 type_size);
 void  array_reserve(Array* da, u64 cap);
-void  array_resize(Array* da, u64 new_cap);
+// False when the allocation fails, the array keeps its old buffer. Pushes
+// into a full array that can't grow are dropped.
+b8    array_resize(Array* da, u64 new_cap);
 void  array_push(Array* da, const void* val);
 void  array_pushf(Array* da, const void* val);
 void  array_pushi(Array* da, const void* val, u64 idx);
@@ -238,6 +662,7 @@ void  array_clear(Array* da);
 void  array_destroy(Array* da);
 
 #define make_array(T)        array_create(sizeof(T))
+#define make_arena_array(a, T) array_create_arena((a), sizeof(T))
 #define push(da, v)          array_push((da), (void*)&(v))
 #define push_front(da, v)    array_pushf((da), (void*)&(v))
 #define push_idx(da, v, idx) array_pushi((da), (void*)&(v), idx)
@@ -381,6 +806,173 @@ f32  dot(Vec4 a, Vec4 b);
 f32  length(Vec4 vec);
 f32  length_sq(Vec4 vec);
 
+#if __cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+
+#include <string.h>
+#include <type_traits>
+
+namespace samlib {
+
+// One `{}` slot. `{:x}` prints integers in hex, `{:.N}` prints floats with N
+// fractional digits.
+struct FormatSlot {
+    b8  hex;
+    s32 precision; // -1 for shortest.
+};
+
+// A format string split at compile time: the literal text with `{{` and `}}`
+// already unescaped, and the slots between its pieces. Piece i ends at
+// `literal_end[i]` and starts where piece i - 1 ended.
+template <u64 N>
+struct FormatString {
+    char       text[N]        = {};
+    u64        literal_end[N] = {};
+    FormatSlot slots[N]       = {};
+    u64        text_length    = 0;
+    u32        slot_count     = 0;
+    b8         valid          = true;
+
+    consteval FormatString(const char (&pattern)[N]) {
+        u64 i = 0;
+        while (i + 1 < N) {
+            char c = pattern[i];
+            if ((c == '{' || c == '}') && pattern[i + 1] == c) {
+                text[text_length++]  = c;
+                i                   += 2;
+                continue;
+            }
+            if (c == '}') {
+                valid = false;
+                return;
+            }
+            if (c != '{') {
+                text[text_length++] = c;
+                i++;
+                continue;
+            }
+
+            FormatSlot slot = {false, -1};
+            i++;
+            if (pattern[i] == ':' && pattern[i + 1] == 'x') {
+                slot.hex  = true;
+                i        += 2;
+            } else if (pattern[i] == ':' && pattern[i + 1] == '.') {
+                i += 2;
+                if (pattern[i] < '0' || pattern[i] > '9') {
+                    valid = false;
+                    return;
+                }
+                slot.precision = 0;
+                while (pattern[i] >= '0' && pattern[i] <= '9') slot.precision = slot.precision * 10 + (pattern[i++] - '0');
+                if (slot.precision > 19) {
+                    valid = false;
+                    return;
+                }
+            }
+            if (pattern[i] != '}') {
+                valid = false;
+                return;
+            }
+            i++;
+            literal_end[slot_count] = text_length;
+            slots[slot_count++]     = slot;
+        }
+        literal_end[slot_count] = text_length;
+    }
+};
+
+// `{:x}` takes integers and enums, `{:.N}` takes floats.
+template <typename T>
+consteval b8 format_slot_fits(FormatSlot slot) {
+    b8 integer = (std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char>) || std::is_enum_v<T>;
+    if (slot.hex && !integer) return false;
+    if (slot.precision >= 0 && !std::is_floating_point_v<T>) return false;
+    return true;
+}
+
+template <FormatString F, typename... Args>
+consteval b8 format_slots_fit() {
+    if (F.slot_count != sizeof...(Args)) return true; // Reported on its own.
+    u32 index = 0;
+    return (format_slot_fits<Args>(F.slots[index++]) && ...);
+}
+
+// Most bytes `format_write` can produce for the argument.
+template <typename T>
+inline u64 format_max_length(const T& arg, FormatSlot slot) {
+    if constexpr (std::is_same_v<T, bool>) return 5;
+    else if constexpr (std::is_same_v<T, char>) return 1;
+    else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) return slot.hex ? 16 : BUILDER_INT_MAX;
+    else if constexpr (std::is_floating_point_v<T>) return slot.precision >= 0 ? BUILDER_PREC_MAX : BUILDER_FLOAT_MAX;
+    else if constexpr (std::is_same_v<T, String>) return arg.length;
+    else if constexpr (std::is_convertible_v<const T&, const char*>) return strlen(arg);
+    else if constexpr (std::is_pointer_v<T>) return 18;
+    else static_assert(sizeof(T) == 0, "samlib::format: unsupported argument type");
+}
+
+template <typename T>
+inline void format_write(String* out, const T& arg, FormatSlot slot) {
+    if constexpr (std::is_same_v<T, bool>) {
+        string_write_str(out, arg ? "true" : "false");
+    } else if constexpr (std::is_same_v<T, char>) {
+        out->buffer[out->length++] = (u8)arg;
+    } else if constexpr (std::is_enum_v<T>) {
+        format_write(out, (std::underlying_type_t<T>)arg, slot);
+    } else if constexpr (std::is_integral_v<T>) {
+        if (slot.hex) string_write_hex(out, (u64)(std::make_unsigned_t<T>)arg);
+        else if constexpr (std::is_signed_v<T>) string_write_s64(out, (s64)arg);
+        else string_write_u64(out, (u64)arg);
+    } else if constexpr (std::is_same_v<T, f32>) {
+        if (slot.precision >= 0) string_write_f32_prec(out, arg, (u32)slot.precision);
+        else string_write_f32(out, arg);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        if (slot.precision >= 0) string_write_f64_prec(out, (f64)arg, (u32)slot.precision);
+        else string_write_f64(out, (f64)arg);
+    } else if constexpr (std::is_same_v<T, String>) {
+        if (arg.length > 0) memcpy(out->buffer + out->length, arg.buffer, arg.length);
+        out->length += arg.length;
+    } else if constexpr (std::is_convertible_v<const T&, const char*>) {
+        string_write_str(out, arg);
+    } else {
+        string_write_ptr(out, (const void*)arg);
+    }
+}
+
+template <FormatString F>
+inline void format_literal(String* out, u32 piece) {
+    u64 begin = piece > 0 ? F.literal_end[piece - 1] : 0;
+    u64 end   = F.literal_end[piece];
+    if (end > begin) memcpy(out->buffer + out->length, F.text + begin, end - begin);
+    out->length += end - begin;
+}
+
+// Appends the formatted text to the builder, e.g.
+//     samlib::format<"{} of {} ({:.2}%)">(sb, done, total, percent);
+// The string is checked against the arguments at compile time. Every argument
+// has a known bound, so the builder grows at most once and the pieces are
+// written with the unchecked `string_write_*` routines. Nothing is written when
+// the arena cannot fit the bound.
+template <FormatString F, typename... Args>
+inline void format(StringBuilder& sb, const Args&... args) {
+    static_assert(F.valid, "samlib::format: malformed format string");
+    static_assert(F.slot_count == sizeof...(Args), "samlib::format: argument count does not match the format string");
+    static_assert(format_slots_fit<F, Args...>(), "samlib::format: {:x} needs an integer argument and {:.N} a float");
+
+    u64 max   = F.text_length;
+    u32 index = 0;
+    ((max += format_max_length(args, F.slots[index++])), ...);
+    if (!string_builder_reserve(&sb, max)) return;
+
+    String* out = &sb.str;
+    format_literal<F>(out, 0);
+    index = 0;
+    ((format_write(out, args, F.slots[index]), format_literal<F>(out, ++index)), ...);
+}
+
+} // namespace samlib
+
+#endif
+
 #endif
 
 #define _SAMLIB_H_